@@ -0,0 +1,16 @@
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include <chrono>
+
+// Wall-clock milliseconds since construction
+struct BenchTimer {
+    std::chrono::steady_clock::time_point start;
+
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+    double millis() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif
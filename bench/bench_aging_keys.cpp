@@ -0,0 +1,83 @@
+// Cost of wait-time aging: the same patients through an EmergencyHeap keyed
+// by priority alone and by AgingPolicy::keyFor. Inserts include computing
+// the key. Arrivals come in time order, a few seconds apart, as at the desk.
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "MinHeap.h"
+#include "bench.h"
+
+struct Arrival {
+    int priority;
+    long long time;
+};
+
+struct Timing {
+    double insertMs;
+    double extractMs;
+    bool ordered;
+};
+
+template <typename KeyOf>
+static Timing run(const vector<Arrival>& arrivals, KeyOf keyFor) {
+    Timing t;
+    EmergencyHeap heap;
+    BenchTimer insertTimer;
+    for (size_t i = 0; i < arrivals.size(); i++) {
+        const Arrival& a = arrivals[i];
+        QueueEntry e = { a.priority, (int)i, keyFor(a), (unsigned long long)i };
+        heap.insert(e);
+    }
+    t.insertMs = insertTimer.millis();
+
+    QueueEntryKey keyOf;
+    t.ordered = true;
+    QueueEntry prev = heap.peek();
+    BenchTimer extractTimer;
+    while (!heap.isEmpty()) {
+        QueueEntry e = heap.extractMin();
+        if (keyOf(e) < keyOf(prev)) t.ordered = false;
+        prev = e;
+    }
+    t.extractMs = extractTimer.millis();
+    return t;
+}
+
+static void report(const char* name, const Timing& t, const Timing& base, int n) {
+    printf("  %-14s insert %7.1f ms (%5.1f ns/op, %+5.1f%%)   extractMin %7.1f ms (%5.1f ns/op, %+5.1f%%)%s\n",
+           name, t.insertMs, t.insertMs * 1e6 / n, 100.0 * (t.insertMs / base.insertMs - 1),
+           t.extractMs, t.extractMs * 1e6 / n, 100.0 * (t.extractMs / base.extractMs - 1),
+           t.ordered ? "" : "   OUT OF ORDER");
+}
+
+struct PriorityOnly {
+    unsigned long long operator()(const Arrival& a) const { return a.priority - 1; }
+};
+
+struct Aged {
+    AgingPolicy aging;
+    unsigned long long operator()(const Arrival& a) const { return aging.keyFor(a.priority, a.time); }
+};
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    printf("bench_aging_keys: %d patients\n", n);
+
+    mt19937_64 rng(1);
+    vector<Arrival> arrivals(n);
+    long long now = 1700000000;
+    for (int i = 0; i < n; i++) {
+        now += rng() % 5;
+        arrivals[i].priority = 1 + rng() % 3;
+        arrivals[i].time = now;
+    }
+
+    // Warm up the allocator and caches, then measure
+    run(arrivals, PriorityOnly());
+    Timing plain = run(arrivals, PriorityOnly());
+    Timing aged = run(arrivals, Aged());
+    report("priority only", plain, plain, n);
+    report("aging keys", aged, plain, n);
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Mass-casualty intake end to end without the GUI: parseIntake on a pasted
+// list of 1M patients, then addPatientsBulk into a fresh backend. The
+// target is 1M patients/s for the two together.
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "bench.h"
+
+static const char* const SYMPTOMS[] = { "blast injury", "smoke inhalation", "fractured arm", "burns" };
+static const char* const DEPARTMENT_NAMES[] = { "General", "Trauma", "Pediatrics" };
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    mt19937 rng(3);
+    string text = "name,age,symptoms,priority,department\n";
+    for (int i = 0; i < n; i++) {
+        text += "Casualty " + to_string(i) + "," + to_string(1 + rng() % 90) + ",";
+        text += SYMPTOMS[rng() % 4];
+        text += "," + to_string(1 + rng() % 3) + ",";
+        text += DEPARTMENT_NAMES[rng() % DEPARTMENTS];
+        text += "\n";
+    }
+    printf("bench_bulk_intake: %d rows, %.1f MB of text\n", n, text.size() / 1e6);
+
+    ReplicationOptions options;
+    options.boardName = "/hospital_queue_bench_" + to_string(getpid());
+    BackendInterface backend(options);
+    backend.finishLoading();
+
+    vector<IntakeRow> rows;
+    vector<string> errors;
+    BenchTimer parseTimer;
+    size_t parsed = parseIntake(text, rows, errors);
+    double parseMs = parseTimer.millis();
+
+    int waiting = backend.getTotalPatients(); // restored from an earlier run
+    bool confirmed;
+    BenchTimer addTimer;
+    int first = backend.addPatientsBulk(rows, confirmed);
+    double addMs = addTimer.millis();
+
+    bool complete = parsed == (size_t)n && errors.empty() && first > 0 && backend.getTotalPatients() == waiting + n;
+    printf("  parseIntake     %7.1f ms  %5.2f M rows/s\n", parseMs, n / parseMs / 1000);
+    printf("  addPatientsBulk %7.1f ms  %5.2f M rows/s\n", addMs, n / addMs / 1000);
+    printf("  total           %7.1f ms  %5.2f M rows/s (target 1.00)%s\n",
+           parseMs + addMs, n / (parseMs + addMs) / 1000, complete ? "" : "   ROWS MISSING");
+    return complete ? 0 : 1;
+}
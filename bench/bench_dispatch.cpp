@@ -0,0 +1,105 @@
+// Dispatch throughput and fairness: department shards with station threads
+// against one heap behind a global lock, pulled by the same number of
+// threads. Fairness is measured apart from the threads, whose completion
+// order also depends on the scheduler: one thread pulls from each
+// department in turn and counts pulls that took a lower priority while a
+// higher one was still waiting anywhere.
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "TreatmentDispatcher.h"
+#include "bench.h"
+
+static const int STATIONS[DEPARTMENTS] = { 2, 1, 1 };
+
+static vector<pair<int, QueueEntry> > makeArrivals(int n) {
+    AgingPolicy aging;
+    aging.enabled = false; // strict priority order
+    mt19937 rng(1);
+    vector<pair<int, QueueEntry> > arrivals;
+    arrivals.reserve(n);
+    for (int i = 0; i < n; i++) {
+        int priority = 1 + rng() % 3;
+        QueueEntry e = { priority, i, aging.keyFor(priority, i), (unsigned long long)i };
+        arrivals.push_back(make_pair((int)(rng() % DEPARTMENTS), e));
+    }
+    return arrivals;
+}
+
+static void runSharded(const vector<pair<int, QueueEntry> >& arrivals) {
+    TreatmentDispatcher dispatcher;
+    for (const auto& a : arrivals) dispatcher.push(a.first, a.second);
+
+    BenchTimer timer;
+    dispatcher.startStations(STATIONS, 0);
+    vector<QueueEntry> order;
+    order.reserve(arrivals.size());
+    while (order.size() < arrivals.size()) {
+        vector<QueueEntry> done = dispatcher.takeCompleted();
+        order.insert(order.end(), done.begin(), done.end());
+    }
+    dispatcher.stopStations();
+    double ms = timer.millis();
+    printf("  sharded, %d stations:        %7.1f ms  %5.2f M/s\n",
+           STATIONS[0] + STATIONS[1] + STATIONS[2], ms, arrivals.size() / ms / 1000);
+}
+
+static void runFairness(const vector<pair<int, QueueEntry> >& arrivals) {
+    TreatmentDispatcher dispatcher;
+    int waiting[4] = { 0, 0, 0, 0 };
+    for (const auto& a : arrivals) {
+        dispatcher.push(a.first, a.second);
+        waiting[a.second.priority]++;
+    }
+
+    int inversions = 0, stolen = 0;
+    QueueEntry e;
+    int from;
+    for (int i = 0; dispatcher.pull(i % DEPARTMENTS, e, &from); i++) {
+        for (int p = 1; p < e.priority; p++) {
+            if (waiting[p] > 0) {
+                inversions++;
+                break;
+            }
+        }
+        waiting[e.priority]--;
+        if (from != i % DEPARTMENTS) stolen++;
+    }
+    printf("  sharded fairness: %d pulls took a lower priority while a higher one waited (%d stolen)\n",
+           inversions, stolen);
+}
+
+static void runGlobalLock(const vector<pair<int, QueueEntry> >& arrivals) {
+    EmergencyHeap heap;
+    for (const auto& a : arrivals) heap.insert(a.second);
+
+    mutex lock;
+    int threads = STATIONS[0] + STATIONS[1] + STATIONS[2];
+    BenchTimer timer;
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&] {
+            while (true) {
+                lock_guard<mutex> guard(lock);
+                if (heap.isEmpty()) break;
+                heap.extractMin();
+            }
+        }));
+    }
+    for (thread& w : workers) w.join();
+    double ms = timer.millis();
+    printf("  single heap + global lock:   %7.1f ms  %5.2f M/s\n", ms, arrivals.size() / ms / 1000);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    printf("bench_dispatch: %d queued patients, %u hardware threads\n", n, thread::hardware_concurrency());
+    vector<pair<int, QueueEntry> > arrivals = makeArrivals(n);
+    runSharded(arrivals);
+    runGlobalLock(arrivals);
+    runFairness(arrivals);
+    return 0;
+}
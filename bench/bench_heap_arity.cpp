@@ -0,0 +1,121 @@
+// EmergencyHeap arity: throughput of each MinHeap arity on 2M queue
+// entries, with hardware cache misses where perf counters are available
+// (perf_event_open; often disabled in containers, then shown as n/a). The
+// heaps keep the handle index EmergencyHeap keeps.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "MinHeap.h"
+#include "bench.h"
+
+// Counts cache misses of this thread between start() and stop()
+class MissCounter {
+private:
+    int fd;
+
+public:
+    MissCounter() {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~MissCounter() {
+        if (fd >= 0) close(fd);
+    }
+
+    void start() {
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    // Misses since start(), or -1 without counters
+    long long stop() {
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+    }
+};
+
+static void report(const char* phase, double ms, long long misses, int n) {
+    if (misses < 0)
+        printf("  %-9s %7.1f ms   misses n/a", phase, ms);
+    else
+        printf("  %-9s %7.1f ms   %5.2f misses/op", phase, ms, (double)misses / n);
+}
+
+template <int Arity>
+static void run(const vector<QueueEntry>& entries) {
+    typedef MinHeap<QueueEntry, QueueEntryKey, Arity, QueueEntryHandle> Heap;
+    int n = entries.size();
+    MissCounter counter;
+    mt19937_64 rng(2);
+    printf("d=%d\n", Arity);
+
+    Heap heap;
+    BenchTimer insertTimer;
+    counter.start();
+    for (const QueueEntry& e : entries) heap.insert(e);
+    report("insert", insertTimer.millis(), counter.stop(), n);
+    printf("\n");
+
+    // Steady state: treat one, register one
+    BenchTimer mixTimer;
+    counter.start();
+    for (int i = 0; i < n; i++) {
+        QueueEntry e = heap.extractMin();
+        e.key += rng() % 1000000;
+        heap.insert(e);
+    }
+    report("pop+push", mixTimer.millis(), counter.stop(), n);
+    printf("\n");
+
+    BenchTimer drainTimer;
+    counter.start();
+    QueueEntryKey keyOf;
+    bool ordered = true;
+    QueueEntry prev = heap.peek();
+    while (!heap.isEmpty()) {
+        QueueEntry e = heap.extractMin();
+        if (keyOf(e) < keyOf(prev)) ordered = false;
+        prev = e;
+    }
+    report("drain", drainTimer.millis(), counter.stop(), n);
+    printf("%s\n", ordered ? "" : "   OUT OF ORDER");
+
+    Heap built;
+    BenchTimer buildTimer;
+    counter.start();
+    built.assign(entries);
+    report("build", buildTimer.millis(), counter.stop(), n);
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    printf("bench_heap_arity: %d entries of %zu bytes\n", n, sizeof(QueueEntry));
+
+    AgingPolicy aging;
+    mt19937_64 rng(1);
+    vector<QueueEntry> entries(n);
+    for (int i = 0; i < n; i++) {
+        int priority = 1 + rng() % 3;
+        entries[i] = { priority, i, aging.keyFor(priority, rng() % 100000000), (unsigned long long)i };
+    }
+    run<2>(entries);
+    run<4>(entries);
+    run<8>(entries);
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Patient ID lookups: PatientIDIndex against std::map (the balanced tree it
+// replaced on this path) over 1M shuffled IDs, with about 9% of the probes
+// missing. Then the same probes split across 2 and 4 reader threads.
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+#include "PatientIDIndex.h"
+#include "bench.h"
+
+static const int PATIENTS = 1000000;
+static const int PROBES = 4000000;
+
+int main() {
+    mt19937 rng(7);
+    vector<int> ids(PATIENTS);
+    for (int i = 0; i < PATIENTS; i++) ids[i] = i + 1;
+    shuffle(ids.begin(), ids.end(), rng);
+
+    PatientIDIndex index;
+    map<int, int> tree;
+    for (int i = 0; i < PATIENTS; i++) {
+        index.insert(ids[i], i);
+        tree[ids[i]] = i;
+    }
+
+    vector<int> probes(PROBES);
+    for (int& p : probes) p = rng() % (PATIENTS + PATIENTS / 10) + 1;
+
+    printf("bench_id_lookup: %d patients, %d lookups, %u hardware threads\n",
+           PATIENTS, PROBES, thread::hardware_concurrency());
+
+    long long hashSum = 0;
+    BenchTimer hashTimer;
+    for (int p : probes) hashSum += index.find(p);
+    double hashMs = hashTimer.millis();
+
+    long long treeSum = 0;
+    BenchTimer treeTimer;
+    for (int p : probes) {
+        map<int, int>::const_iterator it = tree.find(p);
+        treeSum += it == tree.end() ? -1 : it->second;
+    }
+    double treeMs = treeTimer.millis();
+
+    printf("  PatientIDIndex:   %8.1f ms  %6.1f M/s  (%zu MB)\n",
+           hashMs, PROBES / hashMs / 1000, index.memoryUsage() >> 20);
+    printf("  std::map:         %8.1f ms  %6.1f M/s\n", treeMs, PROBES / treeMs / 1000);
+    if (hashSum != treeSum) {
+        printf("  lookups disagree\n");
+        return 1;
+    }
+
+    int readers[] = { 2, 4 };
+    for (int n : readers) {
+        vector<thread> threads;
+        vector<long long> sums(n, 0);
+        BenchTimer timer;
+        for (int t = 0; t < n; t++)
+            threads.push_back(thread([&, t]() {
+                long long sum = 0;
+                for (size_t i = t; i < probes.size(); i += n) sum += index.find(probes[i]);
+                sums[t] = sum;
+            }));
+        for (thread& t : threads) t.join();
+        double ms = timer.millis();
+        printf("  %d readers:        %8.1f ms  %6.1f M/s aggregate\n", n, ms, PROBES / ms / 1000);
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#ifndef ADMISSION_INDEX_H
+#define ADMISSION_INDEX_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+using namespace std;
+
+// Secondary index on admission time (epoch seconds) -> record handle.
+// Kept as a sorted array: live registrations arrive in time order and are
+// appended, so inserts are O(1) in practice and range queries are a pair of
+// binary searches, O(log n + k). A single removal only flags its entry; the
+// flagged entries are dropped in one pass once they make up an eighth of
+// the array, so removal is O(log n) amortized.
+class AdmissionIndex {
+private:
+    struct Entry {
+        long long time;
+        int handle;
+        int removed;   // fits in the padding, entries stay 16 bytes
+
+        bool operator<(const Entry& o) const {
+            return time < o.time || (time == o.time && handle < o.handle);
+        }
+    };
+
+    vector<Entry> entries;
+    bool sorted = true;
+    size_t bulkStart = 0; // entries before this were sorted when the bulk began
+    size_t removedCount = 0;
+
+public:
+    void add(long long time, int handle) {
+        Entry e = { time, handle, 0 };
+        if (sorted && !entries.empty() && e < entries.back()) {
+            // Out of order (clock adjusted): insert in place
+            entries.insert(upper_bound(entries.begin(), entries.end(), e), e);
+        } else {
+            entries.push_back(e);
+        }
+    }
+
+    // Bulk loading: append unsorted, then call finishBulk() once.
+    // Only the appended run is sorted and merged into the place where it
+    // starts, so repeated small bulks over a large index stay cheap.
+    void beginBulk() {
+        if (!sorted) return;
+        sorted = false;
+        bulkStart = entries.size();
+    }
+    void finishBulk() {
+        if (sorted) return;
+        vector<Entry>::iterator mid = entries.begin() + bulkStart;
+        stable_sort(mid, entries.end());
+        if (mid != entries.end())
+            inplace_merge(upper_bound(entries.begin(), mid, *mid), mid, entries.end());
+        sorted = true;
+    }
+
+    // Handles admitted in [from, to], oldest first
+    vector<int> between(long long from, long long to) const {
+        vector<int> result;
+        vector<Entry>::const_iterator lo = lowerBound(from);
+        vector<Entry>::const_iterator hi = lowerBound(to + 1);
+        result.reserve(hi - lo);
+        for (; lo != hi; ++lo) {
+            if (!lo->removed) result.push_back(lo->handle);
+        }
+        return result;
+    }
+
+    int countBetween(long long from, long long to) const {
+        vector<Entry>::const_iterator lo = lowerBound(from);
+        vector<Entry>::const_iterator hi = lowerBound(to + 1);
+        if (removedCount == 0) return hi - lo;
+        int count = 0;
+        for (; lo != hi; ++lo) count += !lo->removed;
+        return count;
+    }
+
+    // Arrivals in each of the last `hours` hours ending at `now`, oldest first
+    vector<int> perHour(long long now, int hours) const {
+        vector<int> counts(hours, 0);
+        for (int h = 0; h < hours; h++) {
+            long long end = now - (long long)(hours - 1 - h) * 3600;
+            counts[h] = countBetween(end - 3600 + 1, end);
+        }
+        return counts;
+    }
+
+    void remove(long long time, int handle) {
+        Entry e = { time, handle, 0 };
+        vector<Entry>::iterator it = sorted ? lower_bound(entries.begin(), entries.end(), e) : entries.begin();
+        // A freed handle can be reused, so skip an earlier removed twin
+        for (; it != entries.end(); ++it) {
+            if (sorted && e < *it) return;
+            if (it->time == time && it->handle == handle && !it->removed) break;
+        }
+        if (it == entries.end()) return;
+        it->removed = 1;
+        removedCount++;
+        if (sorted && removedCount * 8 > entries.size()) compact();
+    }
+
+    // Drops every entry whose handle is flagged (and every removed entry),
+    // in one pass
+    void removeHandles(const vector<char>& dead) {
+        size_t out = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            int h = entries[i].handle;
+            if (entries[i].removed || (h >= 0 && h < (int)dead.size() && dead[h])) continue;
+            entries[out++] = entries[i];
+        }
+        entries.resize(out);
+        removedCount = 0;
+    }
+
+    size_t size() const { return entries.size() - removedCount; }
+
+private:
+    void compact() {
+        removeHandles(vector<char>());
+    }
+
+    vector<Entry>::const_iterator lowerBound(long long time) const {
+        Entry e = { time, -2147483647 - 1, 0 };
+        return lower_bound(entries.begin(), entries.end(), e);
+    }
+};
+
+#endif
@@ -0,0 +1,1020 @@
+#ifndef BACKEND_INTERFACE_H
+#define BACKEND_INTERFACE_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include "MinHeap.h"
+#include "PatientRecordsBST.h"
+#include "PatientColumns.h"
+#include "TreatmentDispatcher.h"
+#include "QueueReplica.h"
+#include "PatientLoader.h"
+#include "ReplicationLog.h"
+#include "QueueCheckpoint.h"
+#include "BulkIntake.h"
+
+// The backend behind the GUI: record store, emergency queue, analytics,
+// replication and persistence. Kept apart from main.cpp so the tests and
+// benchmarks can drive it without a window.
+
+// Max records kept in memory; older discharged patients move to the cold segment
+const size_t HOT_SET_SIZE = 100000;
+
+// Command line: --standby follows a primary, --ack=sync makes the primary
+// wait for the standby before confirming a change, --board=NAME publishes
+// the status board segment under another name (one per running instance)
+struct ReplicationOptions {
+    bool standby = false;
+    AckMode ackMode = ACK_ASYNC;
+    std::string boardName = REPLICA_SHM_NAME;
+};
+
+// Backend Integration Class
+class BackendInterface {
+private:
+    TreatmentDispatcher dispatcher; // per-department emergency queues
+    PatientRecordsBST patientRecords;
+    PatientColumns columns;   // SoA mirror for dashboard analytics
+    int nextPatientID = 1001;
+    unsigned long long nextSeq = 0;
+    AgingPolicy aging;
+    
+    // Moving average of the time between treatments, for projections
+    double serviceSeconds = 300.0;
+    std::chrono::steady_clock::time_point lastDischarge;
+    bool anyDischarge = false;
+    
+    DashboardStats stats;
+    bool statsDirty = true;
+    double statsMillis = 0.0;
+    
+    // Replication: a primary ships its mutation log to a standby, which
+    // replays it and is promoted when the primary dies
+    bool standby = false;
+    AckMode ackMode = ACK_ASYNC;
+    std::string boardName = REPLICA_SHM_NAME;
+    LogShipper shipper;
+    LogReceiver receiver;
+    double failoverMillis = -1.0;
+    
+    // patients.csv is parsed in the background and inserted a batch per frame
+    PatientLoader loader;
+    bool loading = false;
+    int inheritedSkippedRows = 0;
+    
+    // Shared-memory copy of the queue for status boards (--viewer)
+    ReplicaPublisher replica;
+    bool replicaDirty = true;
+    std::chrono::steady_clock::time_point lastPublish;
+    int treatedTotal = 0;
+    
+    // Queue checkpoint, so waiting patients survive a restart or crash
+    CheckpointWriter checkpointWriter;
+    bool checkpointDirty = false;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    int restoredCount = 0;
+    double restoreMillis = -1.0;
+    
+    // Resolve a queue handle into a GUI view of the record
+    Patient toPatient(int handle, int department = GENERAL) {
+        PatientData* pd = patientRecords.getRecord(handle);
+        if (pd == nullptr) return {-1, "None", 0, "", 3, GENERAL};
+        return {pd->patientID, patientRecords.text(pd->nameID), pd->age,
+                patientRecords.text(pd->symptomsID), pd->priorityLevel, department};
+    }
+    
+    void discharge(int handle) {
+        auto now = std::chrono::steady_clock::now();
+        if (anyDischarge) {
+            double interval = std::chrono::duration<double>(now - lastDischarge).count();
+            serviceSeconds = 0.8 * serviceSeconds + 0.2 * interval;
+        }
+        lastDischarge = now;
+        anyDischarge = true;
+        
+        columns.setWaiting(handle, false);
+        patientRecords.markDischarged(handle);
+        treatedTotal++;
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        
+        PatientData* pd = patientRecords.getRecord(handle);
+        if (!standby && pd != nullptr) {
+            LogEntry entry;
+            entry.op = LOG_TREAT;
+            entry.patientID = pd->patientID;
+            shipper.append(std::move(entry));
+        }
+    }
+    
+    // A record that is history, not waiting: loaded rows and snapshot rows
+    bool insertDischarged(const PatientData& pd) {
+        int handle = patientRecords.insertPatient(pd);
+        if (handle < 0) return false;
+        columns.set(handle, pd.patientID, pd.age, pd.priorityLevel, pd.admissionTime, false);
+        patientRecords.markDischarged(handle);
+        return true;
+    }
+    
+    // Store the record once in the BST; the queue only keeps a handle to it,
+    // in the department's shard. Shared by registration and log replay.
+    bool insertQueued(const Patient& p, long long admissionTime, unsigned long long seq) {
+        PatientData pd;
+        pd.patientID = p.id;
+        pd.nameID = patientRecords.intern(p.name);
+        pd.age = p.age;
+        pd.symptomsID = patientRecords.intern(p.symptoms);
+        pd.priorityLevel = p.priority;
+        pd.admissionTime = admissionTime;
+        int handle = patientRecords.insertPatient(pd);
+        if (handle < 0) return false;
+        
+        dispatcher.push(p.department, {p.priority, handle, aging.keyFor(p.priority, admissionTime), seq});
+        
+        columns.set(handle, pd.patientID, pd.age, pd.priorityLevel, pd.admissionTime, true);
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        return true;
+    }
+    
+    // Corrects the record in place; shared by corrections and log replay.
+    // A new priority re-triages a waiting patient, whose key keeps their
+    // arrival time and sequence. Returns the handle, or -1.
+    int applyUpdate(const Patient& p) {
+        PatientData* old = patientRecords.searchPatient(p.id);
+        if (old == nullptr) return -1;
+        PatientData pd = *old;
+        pd.nameID = patientRecords.intern(p.name);
+        pd.age = p.age;
+        pd.symptomsID = patientRecords.intern(p.symptoms);
+        pd.priorityLevel = p.priority;
+        int handle = patientRecords.updatePatient(p.id, pd);
+        
+        dispatcher.update(handle, [&](QueueEntry& e) {
+            e.priority = pd.priorityLevel;
+            e.key = aging.keyFor(e.priority, pd.admissionTime);
+        });
+        columns.set(handle, pd.patientID, pd.age, pd.priorityLevel, pd.admissionTime, columns.isWaiting(handle));
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        return handle;
+    }
+    
+    // A patient at a treatment station cannot be deleted: the station still
+    // holds their handle and reports it when done
+    bool atStation(int handle, bool queued) const {
+        return !queued && columns.isWaiting(handle);
+    }
+    
+    bool applyDelete(int id) {
+        int handle = patientRecords.findHandle(id);
+        if (handle < 0) return false;
+        if (atStation(handle, dispatcher.remove(handle))) return false;
+        patientRecords.deletePatient(id);
+        columns.remove(handle);
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        return true;
+    }
+    
+    // Standby: replays the primary's log on the GUI thread (the reader
+    // thread has acknowledged it already) and takes over if the primary
+    // crashed
+    void applyReplicationLog() {
+        // Checked first: everything sent before the loss is already queued
+        bool lost = receiver.lost();
+        std::vector<LogEntry> entries;
+        receiver.take(entries);
+        applyLogEntries(entries);
+        if (lost) promote();
+    }
+    
+    void applyLogEntries(const std::vector<LogEntry>& entries) {
+        // Runs of inserts (a snapshot, a mass intake) sort into the
+        // admission index once; anything else needs it sorted
+        bool bulk = false;
+        for (const LogEntry& e : entries) {
+            bool insert = e.op == LOG_REGISTER || e.op == LOG_RECORD || e.op == LOG_STATE;
+            if (insert != bulk) {
+                if (insert) patientRecords.beginBulkLoad();
+                else patientRecords.finishBulkLoad();
+                bulk = insert;
+            }
+            switch (e.op) {
+                case LOG_REGISTER: {
+                    Patient p = {e.patientID, e.name.c_str(), e.age, e.symptoms.c_str(), e.priority, e.department};
+                    insertQueued(p, e.admissionTime, e.seq);
+                    if (e.patientID >= nextPatientID) nextPatientID = e.patientID + 1;
+                    if (e.seq >= nextSeq) nextSeq = e.seq + 1;
+                    break;
+                }
+                case LOG_STATE:
+                    aging = e.aging;
+                    if (e.patientID > nextPatientID) nextPatientID = e.patientID;
+                    if (e.seq > nextSeq) nextSeq = e.seq;
+                    inheritedSkippedRows = e.age;
+                    break;
+                case LOG_RECORD: {
+                    PatientData pd(e.patientID, patientRecords.intern(e.name), e.age,
+                                   patientRecords.intern(e.symptoms), e.priority, e.admissionTime);
+                    insertDischarged(pd);
+                    if (e.patientID >= nextPatientID) nextPatientID = e.patientID + 1;
+                    break;
+                }
+                case LOG_TREAT: {
+                    int handle = patientRecords.findHandle(e.patientID);
+                    if (handle >= 0 && dispatcher.remove(handle)) discharge(handle);
+                    break;
+                }
+                case LOG_AGING:
+                    setAgingPolicy(e.aging);
+                    break;
+                case LOG_UPDATE: {
+                    Patient p = {e.patientID, e.name.c_str(), e.age, e.symptoms.c_str(), e.priority, e.department};
+                    applyUpdate(p);
+                    break;
+                }
+                case LOG_DELETE:
+                    applyDelete(e.patientID);
+                    break;
+            }
+        }
+        if (bulk) patientRecords.finishBulkLoad();
+    }
+    
+    // The whole state as log entries for a standby that starts empty:
+    // counters and policy first, then every record in memory. Waiting
+    // patients keep their department and sequence; patients at a station
+    // go as waiting too, as they would through the log, and their treat
+    // entry follows when the station is done.
+    std::vector<LogEntry> buildSnapshot() {
+        std::vector<LogEntry> entries;
+        LogEntry state;
+        state.op = LOG_STATE;
+        state.aging = aging;
+        state.patientID = nextPatientID;
+        state.seq = nextSeq;
+        state.age = getSkippedRows();
+        entries.push_back(state);
+        
+        std::vector<char> queued(patientRecords.recordCount(), 0);
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            for (const auto& e : dispatcher.snapshot(d)) {
+                PatientData* pd = patientRecords.getRecord(e.handle);
+                if (pd == nullptr) continue;
+                queued[e.handle] = 1;
+                entries.push_back(snapshotEntry(*pd, LOG_REGISTER, d, e.seq));
+            }
+        }
+        for (const PatientData& pd : patientRecords.getAllPatients()) {
+            int handle = patientRecords.findHandle(pd.patientID);
+            if (queued[handle]) continue;
+            bool atStation = columns.isWaiting(handle);
+            entries.push_back(snapshotEntry(pd, atStation ? LOG_REGISTER : LOG_RECORD, GENERAL, 0));
+        }
+        return entries;
+    }
+    
+    LogEntry snapshotEntry(const PatientData& pd, int op, int department, unsigned long long seq) {
+        LogEntry entry;
+        entry.op = op;
+        entry.patientID = pd.patientID;
+        entry.age = pd.age;
+        entry.priority = pd.priorityLevel;
+        entry.department = department;
+        entry.admissionTime = pd.admissionTime;
+        entry.seq = seq;
+        entry.name = patientRecords.text(pd.nameID);
+        entry.symptoms = patientRecords.text(pd.symptomsID);
+        return entry;
+    }
+    
+    // Copies the queue head and counters to the replica: at most 10 times
+    // a second while the queue changes, otherwise once a second as a heartbeat
+    void publishReplica() {
+        if (!replica.isOpen()) return;
+        auto now = std::chrono::steady_clock::now();
+        double since = std::chrono::duration<double>(now - lastPublish).count();
+        if (since < (replicaDirty ? 0.1 : 1.0)) return;
+        lastPublish = now;
+        replicaDirty = false;
+        
+        ReplicaSnapshot snap;
+        memset(&snap, 0, sizeof(snap));
+        snap.publishedAt = (long long)time(nullptr);
+        
+        std::vector<std::pair<QueueEntry, int> > entries;
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            for (const auto& e : dispatcher.snapshot(d)) {
+                entries.push_back(std::make_pair(e, d));
+                if (e.priority >= 1 && e.priority <= 3) snap.byPriority[e.priority]++;
+                snap.byDepartment[d]++;
+            }
+        }
+        snap.queued = entries.size();
+        
+        // Only the head is published, so a partial sort is enough
+        size_t count = std::min(entries.size(), (size_t)REPLICA_MAX_ENTRIES);
+        QueueEntryKey keyOf;
+        std::partial_sort(entries.begin(), entries.begin() + count, entries.end(),
+            [&keyOf](const std::pair<QueueEntry, int>& a, const std::pair<QueueEntry, int>& b) {
+                return keyOf(a.first) < keyOf(b.first);
+            });
+        for (size_t i = 0; i < count; i++) {
+            PatientData* pd = patientRecords.getRecord(entries[i].first.handle);
+            if (pd == nullptr) continue;
+            ReplicaEntry& r = snap.entries[snap.entryCount++];
+            r.id = pd->patientID;
+            r.age = pd->age;
+            r.priority = pd->priorityLevel;
+            r.department = entries[i].second;
+            r.admissionTime = pd->admissionTime;
+            snprintf(r.name, sizeof(r.name), "%s", patientRecords.text(pd->nameID));
+            snprintf(r.symptoms, sizeof(r.symptoms), "%s", patientRecords.text(pd->symptomsID));
+        }
+        
+        snap.treated = treatedTotal;
+        snap.archived = patientRecords.coldCount();
+        snap.totalRecords = patientRecords.liveCount() + patientRecords.coldCount();
+        snap.serviceSeconds = serviceSeconds;
+        replica.publish(snap);
+    }
+    
+    // Rebuilds the queue from the checkpoint. Records go in as waiting and
+    // each shard adopts its saved heap array in one O(n) build. Runs before
+    // any patients.csv rows are applied, so the CSV copies of these
+    // patients are skipped as duplicates rather than marked discharged.
+    void restoreQueue() {
+        auto start = std::chrono::steady_clock::now();
+        CheckpointReader reader;
+        if (!reader.open(QUEUE_CHECKPOINT)) return;
+        
+        const CheckpointHeader& header = reader.getHeader();
+        aging = header.aging;
+        if (header.nextSeq > nextSeq) nextSeq = header.nextSeq;
+        
+        std::vector<QueueEntry> shards[DEPARTMENTS];
+        for (int d = 0; d < DEPARTMENTS; d++) shards[d].reserve(header.counts[d]);
+        
+        int dept;
+        CheckpointEntry ce;
+        const char* name;
+        const char* symptoms;
+        patientRecords.beginBulkLoad();
+        while (reader.next(dept, ce, name, symptoms)) {
+            PatientData pd(ce.patientID, patientRecords.intern(name), ce.age,
+                           patientRecords.intern(symptoms), ce.priority, ce.admissionTime);
+            int handle = patientRecords.insertPatient(pd);
+            if (handle < 0) continue;
+            columns.set(handle, pd.patientID, pd.age, pd.priorityLevel, pd.admissionTime, true);
+            shards[dept].push_back({ce.priority, handle, ce.key, ce.seq});
+            // Registered after the last save, so not in patients.csv
+            if (pd.patientID >= nextPatientID) nextPatientID = pd.patientID + 1;
+        }
+        patientRecords.finishBulkLoad();
+        
+        restoredCount = 0;
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            restoredCount += shards[d].size();
+            dispatcher.restore(d, std::move(shards[d]));
+        }
+        restoreMillis = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        statsDirty = true;
+        replicaDirty = true;
+    }
+    
+    // Hands a queue image to the writer thread, at most once a second while
+    // the queue changes. Building the image copies the queue; the disk write
+    // happens off the GUI thread.
+    void checkpointQueue(bool force) {
+        if (!checkpointWriter.isRunning()) return;
+        auto now = std::chrono::steady_clock::now();
+        if (!force && (!checkpointDirty || now - lastCheckpoint < std::chrono::seconds(1))) return;
+        lastCheckpoint = now;
+        checkpointDirty = false;
+        
+        CheckpointImage image;
+        image.begin(aging, nextSeq);
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            for (const auto& e : dispatcher.snapshot(d)) {
+                PatientData* pd = patientRecords.getRecord(e.handle);
+                if (pd == nullptr) continue;
+                image.add(d, e, pd->patientID, pd->age, pd->admissionTime,
+                          patientRecords.text(pd->nameID), patientRecords.text(pd->symptomsID));
+            }
+        }
+        checkpointWriter.submit(image.take());
+    }
+    
+public:
+explicit BackendInterface(const ReplicationOptions& options = ReplicationOptions()) {
+    standby = options.standby;
+    ackMode = options.ackMode;
+    boardName = options.boardName;
+    patientRecords.openColdStore("patients_cold.dat");
+    patientRecords.setHotLimit(HOT_SET_SIZE);
+    columns.addRetired(patientRecords.coldSummary());
+    
+    // A standby starts empty and takes the primary's state when it
+    // connects; it leaves the files, the status boards and the cold segment
+    // to the primary until it is promoted
+    if (standby) {
+        receiver.start(STANDBY_SOCKET);
+    } else {
+        // Waiting patients come back before the first frame
+        restoreQueue();
+        
+        // Reserve IDs above everything on disk (hot and cold) before
+        // loading, so registrations can start right away without colliding
+        int maxID = std::max(patientRecords.maxPatientID(), PatientLoader::scanMaxID("patients.csv"));
+        if (maxID >= nextPatientID) nextPatientID = maxID + 1;
+        
+        // Records arrive through poll() while the GUI is already running
+        loading = loader.start("patients.csv");
+        
+        replica.open(boardName.c_str());
+        shipper.start(STANDBY_SOCKET, ackMode);
+        checkpointWriter.start(QUEUE_CHECKPOINT);
+    }
+}
+    
+    ~BackendInterface() {
+        stopStations();
+        if (standby) return;
+        checkpointQueue(true);
+        checkpointWriter.stop();
+        // Auto-save on exit; the file must not lose rows that are not loaded yet
+        finishLoading();
+        patientRecords.saveToFile(getSavePath());
+        shipper.stop(true);
+    }
+    
+    // Returns false if the patient was not registered: on a standby, or if
+    // the ID is taken (in memory or archived). confirmed is false if the
+    // standby did not acknowledge a registration (ACK_SYNC only).
+    bool addPatient(const Patient& p, bool& confirmed) {
+        confirmed = false;
+        if (standby) return false;
+        long long now = (long long)time(nullptr);
+        unsigned long long seq = nextSeq++;
+        if (!insertQueued(p, now, seq)) return false;
+        
+        LogEntry entry;
+        entry.op = LOG_REGISTER;
+        entry.patientID = p.id;
+        entry.name = p.name;
+        entry.age = p.age;
+        entry.symptoms = p.symptoms;
+        entry.priority = p.priority;
+        entry.department = p.department;
+        entry.admissionTime = now;
+        entry.seq = seq;
+        shipper.append(std::move(entry));
+        confirmed = shipper.sync();
+        return true;
+    }
+    
+    bool isStandby() const {
+        return standby;
+    }
+    
+    // Stops following the primary and starts acting as one
+    void promote() {
+        if (!standby) return;
+        if (receiver.lost()) {
+            failoverMillis = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - receiver.lostTime()).count();
+        }
+        receiver.stop();
+        // The primary was told these are held here (ACK_SYNC confirmed them)
+        std::vector<LogEntry> rest;
+        receiver.take(rest);
+        applyLogEntries(rest);
+        standby = false;
+        // Re-read the cold segment: the primary may have appended to it.
+        // This process never evicted, so it still holds those rows in
+        // memory; drop them before evicting, or they would be archived twice.
+        patientRecords.openColdStore("patients_cold.dat");
+        std::vector<int> archived = patientRecords.alsoCold();
+        if (!archived.empty()) {
+            // Archived means treated; the treat entry was lost with the primary
+            std::vector<char> gone(patientRecords.recordCount(), 0);
+            for (int id : archived) gone[patientRecords.findHandle(id)] = 1;
+            dispatcher.rewrite([&gone](QueueEntry& e) { return !gone[e.handle]; });
+            for (int handle : patientRecords.deletePatients(archived)) columns.remove(handle);
+        }
+        columns.setRetired(patientRecords.coldSummary());
+        evictColdRecords();
+        replica.open(boardName.c_str());
+        shipper.start(STANDBY_SOCKET, ackMode);
+        checkpointWriter.start(QUEUE_CHECKPOINT);
+        checkpointDirty = true;
+        replicaDirty = true;
+    }
+    
+    // Milliseconds from losing the primary to promotion, or -1
+    double getFailoverMillis() const {
+        return failoverMillis;
+    }
+    
+    // Startup restore from the queue checkpoint; -1 ms if there was none
+    int getRestoredCount() const {
+        return restoredCount;
+    }
+    
+    double getRestoreMillis() const {
+        return restoreMillis;
+    }
+    
+    bool checkpointFailing() {
+        return checkpointWriter.isRunning() && !checkpointWriter.lastWriteOk();
+    }
+    
+    const LogReceiver& getReceiver() const {
+        return receiver;
+    }
+    
+    // A standby whose state cannot be continued; the caller replaces the
+    // backend with a fresh one, which bootstraps from a new snapshot
+    bool needsRestart() const {
+        return standby && receiver.needsRestart();
+    }
+    
+    bool standbyConnected() const {
+        return shipper.isConnected();
+    }
+    
+    // Log entries the standby has not acknowledged yet
+    unsigned long long standbyLag() {
+        return shipper.lastLSN() - shipper.lastAcked();
+    }
+    
+    AckMode getAckMode() const {
+        return ackMode;
+    }
+    
+    // All departments, in treatment order (aging applied)
+    std::vector<Patient> getQueuedPatients() {
+        std::vector<std::pair<QueueEntry, int> > entries;
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            for (const auto& e : dispatcher.snapshot(d)) {
+                entries.push_back(std::make_pair(e, d));
+            }
+        }
+        QueueEntryKey keyOf;
+        std::sort(entries.begin(), entries.end(),
+                  [&keyOf](const std::pair<QueueEntry, int>& a, const std::pair<QueueEntry, int>& b) {
+                      return keyOf(a.first) < keyOf(b.first);
+                  });
+        
+        std::vector<Patient> list;
+        list.reserve(entries.size());
+        for (const auto& e : entries) {
+            list.push_back(toPatient(e.first.handle, e.second));
+        }
+        return list;
+    }
+    
+    // Fills a caller-owned copy; falls through to the cold segment for
+    // discharged patients
+    bool searchPatient(int id, PatientRecord& out) {
+        return patientRecords.findPatient(id, out);
+    }
+    
+    int getTotalPatients() {
+        return dispatcher.size();
+    }
+    
+    int getPatientsByPriority(int priority) {
+        int count = 0;
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            for (const auto& e : dispatcher.snapshot(d)) {
+                if (e.priority == priority) count++;
+            }
+        }
+        return count;
+    }
+    
+    const AgingPolicy& getAgingPolicy() const {
+        return aging;
+    }
+    
+    // Re-keys the waiting patients once; no work is needed per tick
+    void setAgingPolicy(const AgingPolicy& policy) {
+        aging = policy;
+        dispatcher.rekey([this](const QueueEntry& e) {
+            PatientData* pd = patientRecords.getRecord(e.handle);
+            long long arrival = pd ? pd->admissionTime : 0;
+            return aging.keyFor(e.priority, arrival);
+        });
+        replicaDirty = true;
+        checkpointDirty = true;
+        
+        if (!standby) {
+            LogEntry entry;
+            entry.op = LOG_AGING;
+            entry.aging = policy;
+            shipper.append(std::move(entry));
+            shipper.sync();
+        }
+    }
+    
+    // Expected wait for the patient at this queue position
+    double getProjectedWaitSeconds(int position) const {
+        return (position + 1) * serviceSeconds;
+    }
+    
+    int getNextID() {
+        return nextPatientID++;
+    }
+    
+    // Reserves count consecutive IDs and returns the first
+    int getIDBlock(int count) {
+        int first = nextPatientID;
+        nextPatientID += count;
+        return first;
+    }
+    
+    // Mass-casualty intake: one ID block for the batch, one sorted bulk
+    // insert into the record store and one heap merge per department.
+    // Returns the first ID (the batch has first .. first + size - 1), or -1
+    // on a standby. confirmed is false if the standby did not acknowledge.
+    int addPatientsBulk(const std::vector<IntakeRow>& rows, bool& confirmed) {
+        confirmed = false;
+        if (standby || rows.empty()) return -1;
+        long long now = (long long)time(nullptr);
+        int first = getIDBlock(rows.size());
+        
+        std::vector<PatientData> block;
+        block.reserve(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) {
+            const IntakeRow& r = rows[i];
+            block.push_back(PatientData(first + (int)i, patientRecords.intern(r.name), r.age,
+                                        patientRecords.intern(r.symptoms), r.priority, now));
+        }
+        patientRecords.beginBulkLoad();
+        std::vector<int> handles = patientRecords.insertBlock(block);
+        patientRecords.finishBulkLoad();
+        
+        std::vector<QueueEntry> queues[DEPARTMENTS];
+        std::vector<LogEntry> log;
+        log.reserve(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (handles[i] < 0) continue;
+            const IntakeRow& r = rows[i];
+            int dept = r.department >= 0 && r.department < DEPARTMENTS ? r.department : GENERAL;
+            unsigned long long seq = nextSeq++;
+            queues[dept].push_back({r.priority, handles[i], aging.keyFor(r.priority, now), seq});
+            columns.set(handles[i], block[i].patientID, r.age, r.priority, now, true);
+            
+            LogEntry entry;
+            entry.op = LOG_REGISTER;
+            entry.patientID = block[i].patientID;
+            entry.name = r.name;
+            entry.age = r.age;
+            entry.symptoms = r.symptoms;
+            entry.priority = r.priority;
+            entry.department = dept;
+            entry.admissionTime = now;
+            entry.seq = seq;
+            log.push_back(std::move(entry));
+        }
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            if (!queues[d].empty()) dispatcher.pushBulk(d, std::move(queues[d]));
+        }
+        shipper.appendBatch(log);
+        
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        confirmed = shipper.sync();
+        return first;
+    }
+    
+    // Corrections (retriage included). False on a standby or if the ID is
+    // not in memory; archived records are read-only.
+    bool updatePatient(const Patient& p) {
+        if (standby || applyUpdate(p) < 0) return false;
+        
+        LogEntry entry;
+        entry.op = LOG_UPDATE;
+        entry.patientID = p.id;
+        entry.name = p.name;
+        entry.age = p.age;
+        entry.symptoms = p.symptoms;
+        entry.priority = p.priority;
+        shipper.append(std::move(entry));
+        shipper.sync();
+        return true;
+    }
+    
+    // O(log n) in the record store; a waiting patient also leaves the queue.
+    // False on a standby, for unknown IDs and for patients being treated.
+    bool deletePatient(int id) {
+        if (standby || !applyDelete(id)) return false;
+        
+        LogEntry entry;
+        entry.op = LOG_DELETE;
+        entry.patientID = id;
+        shipper.append(std::move(entry));
+        shipper.sync();
+        return true;
+    }
+    
+    // Batch corrections: records change in place, the admission index is
+    // fixed up once and each queue shard is rebuilt once. Returns the
+    // number of records changed.
+    int updatePatients(const std::vector<Patient>& changes) {
+        if (standby) return 0;
+        std::vector<PatientData> fields;
+        std::vector<const Patient*> sources;
+        fields.reserve(changes.size());
+        for (const Patient& p : changes) {
+            PatientData* old = patientRecords.searchPatient(p.id);
+            if (old == nullptr) continue;
+            PatientData pd = *old;
+            pd.nameID = patientRecords.intern(p.name);
+            pd.age = p.age;
+            pd.symptomsID = patientRecords.intern(p.symptoms);
+            pd.priorityLevel = p.priority;
+            fields.push_back(pd);
+            sources.push_back(&p);
+        }
+        std::vector<int> handles = patientRecords.updatePatients(fields);
+        
+        std::vector<char> changed(patientRecords.recordCount(), 0);
+        std::vector<LogEntry> log;
+        log.reserve(fields.size());
+        for (size_t i = 0; i < fields.size(); i++) {
+            const PatientData& pd = fields[i];
+            changed[handles[i]] = 1;
+            columns.set(handles[i], pd.patientID, pd.age, pd.priorityLevel, pd.admissionTime,
+                        columns.isWaiting(handles[i]));
+            
+            LogEntry entry;
+            entry.op = LOG_UPDATE;
+            entry.patientID = pd.patientID;
+            entry.name = sources[i]->name;
+            entry.age = pd.age;
+            entry.symptoms = sources[i]->symptoms;
+            entry.priority = pd.priorityLevel;
+            log.push_back(std::move(entry));
+        }
+        dispatcher.rewrite([&](QueueEntry& e) {
+            if (!changed[e.handle]) return true;
+            PatientData* pd = patientRecords.getRecord(e.handle);
+            e.priority = pd->priorityLevel;
+            e.key = aging.keyFor(e.priority, pd->admissionTime);
+            return true;
+        });
+        
+        shipper.appendBatch(log);
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        shipper.sync();
+        return fields.size();
+    }
+    
+    // Batch delete: one rebuild per queue shard and one pass over the
+    // admission index. Patients being treated are skipped. Returns the
+    // number of records deleted.
+    int deletePatients(const std::vector<int>& ids) {
+        if (standby) return 0;
+        std::vector<char> doomed(patientRecords.recordCount(), 0);
+        for (int id : ids) {
+            int handle = patientRecords.findHandle(id);
+            if (handle >= 0) doomed[handle] = 1;
+        }
+        std::vector<char> queued(doomed.size(), 0);
+        dispatcher.rewrite([&](QueueEntry& e) {
+            if (!doomed[e.handle]) return true;
+            queued[e.handle] = 1;
+            return false;
+        });
+        
+        std::vector<int> deletable;
+        std::vector<LogEntry> log;
+        for (int id : ids) {
+            int handle = patientRecords.findHandle(id);
+            if (handle < 0 || !doomed[handle] || atStation(handle, queued[handle])) continue;
+            doomed[handle] = 0; // listed twice
+            deletable.push_back(id);
+            columns.remove(handle);
+            
+            LogEntry entry;
+            entry.op = LOG_DELETE;
+            entry.patientID = id;
+            log.push_back(std::move(entry));
+        }
+        patientRecords.deletePatients(deletable);
+        
+        shipper.appendBatch(log);
+        statsDirty = true;
+        replicaDirty = true;
+        checkpointDirty = true;
+        shipper.sync();
+        return deletable.size();
+    }
+    
+    Patient getNextPatient() {
+        return toPatient(dispatcher.peekBest().handle);
+    }
+    
+    void treatNextPatient() {
+        if (standby) return;
+        QueueEntry e;
+        if (!dispatcher.pull(-1, e)) return;
+        discharge(e.handle);
+        evictColdRecords();
+        shipper.sync();
+    }
+    
+    // Inserts loaded rows for about 4 ms per call. Loaded records are
+    // history, none of them are waiting.
+    void applyLoadedRecords() {
+        if (!loading) return;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<PatientRecord> batch;
+        int applied = 0;
+        
+        patientRecords.beginBulkLoad();
+        while (loader.take(batch, 1024) > 0) {
+            for (const PatientRecord& r : batch) {
+                PatientData pd(r.patientID, patientRecords.intern(r.name), r.age,
+                               patientRecords.intern(r.symptoms), r.priorityLevel, r.admissionTime);
+                if (insertDischarged(pd)) applied++;
+            }
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(4)) break;
+        }
+        patientRecords.finishBulkLoad();
+        
+        if (applied > 0) {
+            evictColdRecords();
+            statsDirty = true;
+            replicaDirty = true;
+        }
+        if (loader.done()) loading = false;
+    }
+    
+    void finishLoading() {
+        while (loading) {
+            applyLoadedRecords();
+            if (loading) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    
+    bool isLoading() const {
+        return loading;
+    }
+    
+    float getLoadProgress() const {
+        return loader.progress();
+    }
+    
+    // Malformed patients.csv rows left out of the load (by the primary this
+    // standby took over from, if it was promoted)
+    int getSkippedRows() const {
+        return loader.skippedRows() + inheritedSkippedRows;
+    }
+    
+    // Saving over patients.csv would lose the rows that could not be read,
+    // so saves then go to a file beside it
+    const char* getSavePath() const {
+        return getSkippedRows() > 0 ? "patients_recovered.csv" : "patients.csv";
+    }
+    
+    // Called once per frame: applies loaded records and treatments finished
+    // by the stations, and refreshes the replica
+    void poll() {
+        applyLoadedRecords();
+        if (standby) {
+            applyReplicationLog();
+            return;
+        }
+        std::vector<QueueEntry> done = dispatcher.takeCompleted();
+        for (const auto& e : done) {
+            discharge(e.handle);
+        }
+        if (!done.empty()) {
+            evictColdRecords();
+            shipper.sync();
+        }
+        // Not while loading: rows still arriving from patients.csv are not
+        // logged, so the snapshot has to come after them
+        if (!loading && shipper.snapshotRequested()) {
+            std::vector<LogEntry> state = buildSnapshot();
+            shipper.provideSnapshot(state);
+        }
+        publishReplica();
+        checkpointQueue(false);
+    }
+    
+    void startStations(const int perDept[DEPARTMENTS], int treatmentMillis) {
+        dispatcher.startStations(perDept, treatmentMillis);
+    }
+    
+    void stopStations() {
+        dispatcher.stopStations();
+        poll();
+    }
+    
+    bool stationsRunning() const {
+        return dispatcher.stationsRunning();
+    }
+    
+    int getTreatedBy(int dept) const {
+        return dispatcher.treatedBy(dept);
+    }
+    
+    int getStolenBy(int dept) const {
+        return dispatcher.stolenBy(dept);
+    }
+    
+    void evictColdRecords() {
+        // The cold segment file belongs to the primary
+        if (standby) return;
+        for (int handle : patientRecords.evictColdRecords()) {
+            columns.retire(handle);
+        }
+    }
+    
+    int getArchivedCount() {
+        return patientRecords.coldCount();
+    }
+    
+    // Streams the cold archive; row groups outside the filter are skipped
+    std::vector<PatientRecord> scanArchive(const ArchiveFilter& filter, int limit,
+                                           int& groupsRead, int& groupsSkipped) {
+        std::vector<PatientRecord> list;
+        ArchiveScanner scanner;
+        groupsRead = groupsSkipped = 0;
+        if (!scanner.open(patientRecords.coldFilename(), filter)) return list;
+        
+        PatientRecord r;
+        while ((int)list.size() < limit && scanner.next(r)) {
+            list.push_back(r);
+        }
+        groupsRead = scanner.groupsRead;
+        groupsSkipped = scanner.groupsSkipped;
+        return list;
+    }
+    
+    // Recomputed with the column kernels only after the data changed
+    const DashboardStats& getDashboardStats(double& millis) {
+        if (statsDirty) {
+            auto start = std::chrono::steady_clock::now();
+            stats = columns.computeStats();
+            statsMillis = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            statsDirty = false;
+        }
+        millis = statsMillis;
+        return stats;
+    }
+    
+    // Refused while loading: the file still holds rows not yet in memory.
+    // A standby never writes it.
+    bool saveToFile() {
+        if (loading || standby) return false;
+        return patientRecords.saveToFile(getSavePath());
+    }
+    
+    int getTreeHeight() const {
+        return patientRecords.treeHeight();
+    }
+    
+    std::vector<PatientData> getAllRecords() {
+        return patientRecords.getAllPatients();
+    }
+    
+    // Uses the admission time index, O(log n + k)
+    std::vector<PatientData> getRecordsAdmittedBetween(long long from, long long to) {
+        std::vector<PatientData> list;
+        for (int handle : patientRecords.admittedBetween(from, to)) {
+            list.push_back(*patientRecords.getRecord(handle));
+        }
+        return list;
+    }
+    
+    std::vector<int> getArrivalsPerHour(int hours) {
+        return patientRecords.arrivalsPerHour((long long)time(nullptr), hours);
+    }
+    
+    const char* text(unsigned int id) {
+        return patientRecords.text(id);
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "BulkIntake.h"
+#include "TreatmentDispatcher.h"
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+// [begin, end) of one field, whitespace trimmed
+struct Field {
+    const char* begin;
+    const char* end;
+    size_t size() const { return end - begin; }
+};
+
+static Field trim(const char* b, const char* e) {
+    while (b < e && (*b == ' ' || *b == '\t')) b++;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) e--;
+    Field f = { b, e };
+    return f;
+}
+
+static bool toInt(const Field& f, int& out) {
+    if (f.size() == 0 || f.size() > 9) return false;
+    int value = 0;
+    for (const char* p = f.begin; p < f.end; p++) {
+        if (*p < '0' || *p > '9') return false;
+        value = value * 10 + (*p - '0');
+    }
+    out = value;
+    return true;
+}
+
+static bool toDepartment(const Field& f, int& out) {
+    if (toInt(f, out)) return out >= 0 && out < DEPARTMENTS;
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        const char* name = departmentName(d);
+        if (strlen(name) == f.size() && strncasecmp(name, f.begin, f.size()) == 0) {
+            out = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void reject(vector<string>& errors, size_t line, const char* reason) {
+    char msg[96];
+    snprintf(msg, sizeof(msg), "line %zu: %s", line, reason);
+    errors.push_back(msg);
+}
+
+size_t parseIntake(const char* text, size_t length, vector<IntakeRow>& rows, vector<string>& errors) {
+    size_t added = 0;
+    size_t lineNo = 0;
+    const char* end = text + length;
+    const char* p = text;
+
+    while (p < end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        lineNo++;
+
+        Field fields[5];
+        int count = 0;
+        const char* start = p;
+        for (const char* q = p; ; q++) {
+            if (q == eol || *q == ',') {
+                if (count < 5) fields[count] = trim(start, q);
+                count++;
+                start = q + 1;
+                if (q == eol) break;
+            }
+        }
+        p = eol + 1;
+
+        if (count == 1 && fields[0].size() == 0) continue;
+        if (lineNo == 1 && fields[0].size() == 4 && strncasecmp(fields[0].begin, "name", 4) == 0) continue;
+
+        IntakeRow row;
+        if (count < 4 || count > 5) {
+            reject(errors, lineNo, "expected name,age,symptoms,priority[,department]");
+        } else if (fields[0].size() == 0) {
+            reject(errors, lineNo, "name is empty");
+        } else if (!toInt(fields[1], row.age) || row.age <= 0 || row.age > 150) {
+            reject(errors, lineNo, "age must be 1-150");
+        } else if (fields[2].size() == 0) {
+            reject(errors, lineNo, "symptoms are empty");
+        } else if (!toInt(fields[3], row.priority) || row.priority < 1 || row.priority > 3) {
+            reject(errors, lineNo, "priority must be 1, 2 or 3");
+        } else if (count == 5 && !toDepartment(fields[4], row.department)) {
+            reject(errors, lineNo, "unknown department");
+        } else {
+            row.name.assign(fields[0].begin, fields[0].size());
+            row.symptoms.assign(fields[2].begin, fields[2].size());
+            rows.push_back(std::move(row));
+            added++;
+        }
+    }
+    return added;
+}
+
+size_t parseIntake(const string& text, vector<IntakeRow>& rows, vector<string>& errors) {
+    return parseIntake(text.data(), text.size(), rows, errors);
+}
+
+bool readIntakeFile(const string& filename, vector<IntakeRow>& rows, vector<string>& errors) {
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (!f) return false;
+    string text;
+    char buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+    parseIntake(text, rows, errors);
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef BULK_INTAKE_H
+#define BULK_INTAKE_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Mass-casualty intake lists, pasted or imported from a file.
+// Rows carry no ID: the backend gives the whole batch one contiguous block
+// of IDs (see BackendInterface::addPatientsBulk).
+//
+// One patient per line:  name,age,symptoms,priority[,department]
+// priority is 1-3; department is 0-2 or a name (General, Trauma,
+// Pediatrics) and defaults to General. Blank lines and a leading
+// "name,..." header are skipped.
+
+struct IntakeRow {
+    string name;
+    int age;
+    string symptoms;
+    int priority;
+    int department;
+
+    IntakeRow() : age(0), priority(3), department(0) {}
+};
+
+// Appends the valid rows; each bad line adds "line N: reason" to errors.
+// Returns the number of rows added.
+size_t parseIntake(const char* text, size_t length, vector<IntakeRow>& rows, vector<string>& errors);
+size_t parseIntake(const string& text, vector<IntakeRow>& rows, vector<string>& errors);
+// False if the file cannot be read
+bool readIntakeFile(const string& filename, vector<IntakeRow>& rows, vector<string>& errors);
+
+#endif
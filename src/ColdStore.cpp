@@ -0,0 +1,144 @@
+#include "ColdStore.h"
+#include <algorithm>
+#include <unistd.h>
+
+ColdStore::ColdStore() : fileEnd(0), recordTotal(0), maxID(0), cachedGroup(-1) {}
+
+bool ColdStore::open(const string& file) {
+    // Closed until the file checks out, so a failed open cannot be appended to
+    filename.clear();
+    fileEnd = 0;
+    groups.clear();
+    cachedGroup = -1;
+    recordTotal = 0;
+    maxID = 0;
+    summary.clear();
+
+    ifstream in(file, ios::binary);
+    if (!in.is_open()) {
+        // New segment
+        ofstream out(file, ios::binary);
+        if (!out.is_open() || !archiveWriteMagic(out)) return false;
+        filename = file;
+        fileEnd = 4;
+        return true;
+    }
+
+    if (!archiveCheckMagic(in)) return false;
+    in.seekg(0, ios::end);
+    long long size = in.tellg();
+    in.seekg(4);
+    fileEnd = 4;
+
+    // Walk row group headers; a torn group at the end (crash mid-append) is
+    // cut off below, so a shorter next append cannot leave its stale bytes
+    // to be read as a header.
+    Group g;
+    while (archiveReadHeader(in, g.header)) {
+        g.payloadOffset = fileEnd + sizeof(RowGroupHeader);
+        if (g.payloadOffset + g.header.payloadBytes > size) break;
+        in.seekg(g.header.payloadBytes, ios::cur);
+
+        groups.push_back(g);
+        recordTotal += g.header.rows;
+        if (g.header.maxID > maxID) maxID = g.header.maxID;
+        summary.merge(g.header.summary);
+        fileEnd = g.payloadOffset + g.header.payloadBytes;
+    }
+    in.close();
+    if (fileEnd < size && truncate(file.c_str(), fileEnd) != 0) return false;
+
+    filename = file;
+    return true;
+}
+
+static bool byID(const PatientRecord& a, const PatientRecord& b) {
+    return a.patientID < b.patientID;
+}
+
+bool ColdStore::appendBlock(vector<PatientRecord>& batch) {
+    if (!isOpen() || batch.empty()) return false;
+    sort(batch.begin(), batch.end(), byID);
+
+    fstream out(filename, ios::in | ios::out | ios::binary);
+    if (!out.is_open()) return false;
+    out.seekp(fileEnd);
+
+    vector<Group> added;
+    long long offset = fileEnd;
+    string payload;
+    for (size_t start = 0; start < batch.size(); start += ARCHIVE_ROW_GROUP) {
+        size_t stop = min(batch.size(), start + ARCHIVE_ROW_GROUP);
+        vector<PatientRecord> rows(batch.begin() + start, batch.begin() + stop);
+
+        Group g;
+        encodeRowGroup(rows, g.header, payload);
+        if (!archiveWriteGroup(out, g.header, payload)) return false;
+        g.payloadOffset = offset + sizeof(RowGroupHeader);
+        offset = g.payloadOffset + payload.size();
+        added.push_back(g);
+    }
+    out.flush();
+    if (!out) return false;
+
+    fileEnd = offset;
+    for (const Group& g : added) {
+        groups.push_back(g);
+        recordTotal += g.header.rows;
+        if (g.header.maxID > maxID) maxID = g.header.maxID;
+        summary.merge(g.header.summary);
+    }
+    return true;
+}
+
+bool ColdStore::find(int id, PatientRecord& out) const {
+    ArchiveFilter filter;
+    filter.minID = filter.maxID = id;
+
+    ifstream in;
+    for (size_t i = groups.size(); i-- > 0; ) {
+        const Group& g = groups[i];
+        if (!filter.mayMatch(g.header)) continue;
+
+        if (!in.is_open()) {
+            in.open(filename, ios::binary);
+            if (!in.is_open()) return false;
+        }
+        string payload(g.header.payloadBytes, '\0');
+        in.seekg(g.payloadOffset);
+        if (!in.read(&payload[0], payload.size())) return false;
+
+        vector<PatientRecord> found;
+        if (!decodeRowGroup(g.header, payload, filter, found)) return false;
+        if (!found.empty()) {
+            out = found[0];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ColdStore::contains(int id) const {
+    if (groups.empty() || id > maxID) return false;
+
+    ifstream in;
+    for (size_t i = groups.size(); i-- > 0; ) {
+        const Group& g = groups[i];
+        if (id < g.header.minID || id > g.header.maxID) continue;
+
+        if ((int)i != cachedGroup) {
+            if (!in.is_open()) {
+                in.open(filename, ios::binary);
+                if (!in.is_open()) return false;
+            }
+            string payload(g.header.payloadBytes, '\0');
+            in.seekg(g.payloadOffset);
+            if (!in.read(&payload[0], payload.size())) return false;
+            cachedGroup = -1;
+            if (!decodeRowGroupIDs(g.header, payload, cachedIDs)) continue;
+            cachedGroup = i;
+        }
+        if (binary_search(cachedIDs.begin(), cachedIDs.end(), id)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+#ifndef COLD_STORE_H
+#define COLD_STORE_H
+
+#include <string>
+#include <vector>
+#include "PatientArchive.h"
+
+using namespace std;
+
+// On-disk cold tier for discharged patients, stored in the compressed
+// archive format (see PatientArchive.h). Each eviction batch is sorted by ID
+// and written as one or more row groups. Only the row group headers are kept
+// in memory as a sparse index, so a lookup decodes at most the row groups
+// whose ID range covers the key.
+class ColdStore {
+private:
+    struct Group {
+        long long payloadOffset;
+        RowGroupHeader header;
+    };
+
+    string filename;
+    vector<Group> groups;
+    long long fileEnd;     // end of the last complete row group
+    size_t recordTotal;
+    int maxID;
+    RetiredSummary summary; // analytics for everything stored here
+
+    // IDs of the row group last probed by contains(); loads walk IDs in
+    // order, so consecutive probes mostly land in the same group
+    mutable int cachedGroup;
+    mutable vector<int> cachedIDs;
+
+public:
+    ColdStore();
+
+    // Opens (or creates) the segment file and rebuilds the in-memory index
+    bool open(const string& file);
+    bool isOpen() const { return !filename.empty(); }
+    const string& getFilename() const { return filename; }
+
+    // Writes the batch as new row groups; the batch is sorted by ID in place
+    bool appendBlock(vector<PatientRecord>& batch);
+    bool find(int id, PatientRecord& out) const;
+    // ID check only: no I/O for IDs outside every row group's range
+    bool contains(int id) const;
+
+    size_t size() const { return recordTotal; }
+    int maxPatientID() const { return maxID; }
+    const RetiredSummary& getSummary() const { return summary; }
+    size_t indexMemory() const { return groups.capacity() * sizeof(Group); }
+};
+
+#endif
@@ -4,79 +4,284 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <utility>
 
 using namespace std;
 
+// Read-only view of a patient handed to the GUI. The queue itself does not
+// store these, it only stores QueueEntry handles into the record store.
+// Text points into the record store's string pool and is only valid until
+// the backend next evicts records (poll, treatNextPatient, promote), which
+// may compact the pool. Use it within the frame it was fetched in.
 struct Patient {
     int id;
-    string name;
+    const char* name;
     int age;
-    string symptoms;
+    const char* symptoms;
     int priority; // 1 = Critical, 2 = Urgent, 3 = Standard
+    int department; // Department enum, see TreatmentDispatcher.h
 };
 
+// Compact queue entry (24 bytes): sifting moves these instead of full records
+struct QueueEntry {
+    int priority;             // 1 = Critical, 2 = Urgent, 3 = Standard
+    int handle;               // index into PatientRecordsBST's record store
+    unsigned long long key;   // effective urgency, smaller first (see AgingPolicy)
+    unsigned long long seq;   // arrival sequence: first come, first served on equal keys
+};
+
+// Wait-time aging. A patient's key is their arrival time plus the offset of
+// their priority level, so a lower priority that has waited longer than the
+// difference in offsets comes first. Keys are fixed at insertion and keep
+// their relative order as time passes, so aging needs no re-heapify.
+// Critical patients form their own tier and always come first.
+struct AgingPolicy {
+    bool enabled;
+    int offsetMinutes[4]; // indexed by priority; critical (1) is unused
+
+    AgingPolicy() : enabled(true) {
+        offsetMinutes[0] = offsetMinutes[1] = offsetMinutes[2] = 0;
+        offsetMinutes[3] = 120;
+    }
+
+    // Layout: [62] non-critical tier | [2..61] deadline seconds | [0..1] priority - 1.
+    // Equal deadlines go to the more urgent level; the arrival sequence is
+    // kept outside the key (QueueEntry::seq), so it never wraps.
+    unsigned long long keyFor(int priority, long long arrival) const {
+        const long long STRICT_STEP = 1LL << 34; // ~500 years: pure priority order
+        if (priority < 1) priority = 1;
+        if (priority > 3) priority = 3;
+        if (arrival < 0) arrival = 0;
+
+        long long offset = enabled ? (long long)offsetMinutes[priority] * 60
+                                   : (priority - 1) * STRICT_STEP;
+        unsigned long long deadline = arrival + (offset > 0 ? offset : 0);
+        if (deadline >= (1ULL << 60)) deadline = (1ULL << 60) - 1;
+
+        unsigned long long tier = priority > 1 ? 1ULL << 62 : 0;
+        return tier | (deadline << 2) | (unsigned long long)(priority - 1);
+    }
+
+    // Priority level encoded in a key
+    static int priorityOf(unsigned long long key) {
+        return (int)(key & 3) + 1;
+    }
+};
+
+// Sort key of a queue entry for MinHeap: urgency, then arrival
+struct QueueEntryKey {
+    pair<unsigned long long, unsigned long long> operator()(const QueueEntry& e) const {
+        return make_pair(e.key, e.seq);
+    }
+};
+
+// Handle of a queue entry for MinHeap's position index
+struct QueueEntryHandle {
+    int operator()(const QueueEntry& e) const {
+        return e.handle;
+    }
+};
+
+// No position index: every element is untracked (handle -1)
+template <typename T>
+struct NoHandle {
+    int operator()(const T&) const {
+        return -1;
+    }
+};
+
+// Header-only d-ary min-heap. KeyFn maps an element to a comparable key and
+// Arity (2, 4 or 8) is fixed at compile time, so both the comparison and the
+// child index arithmetic inline. Sifting moves a hole instead of swapping.
+// HandleFn maps an element to a small non-negative handle; the heap then
+// keeps handle -> position current through every move, so an element can
+// be found in O(1) and removed or re-sifted in O(log n).
+template <typename T, typename KeyFn, int Arity = 2, typename HandleFn = NoHandle<T> >
 class MinHeap {
+    static_assert(Arity == 2 || Arity == 4 || Arity == 8, "MinHeap arity must be 2, 4 or 8");
+
 private:
-    vector<Patient> heap;
+    vector<T> heap;
+    KeyFn keyOf;
+    HandleFn handleOf;
+    vector<int> positions; // by handle; -1 = not in the heap
+
+    bool before(const T& a, const T& b) const {
+        return keyOf(a) < keyOf(b);
+    }
 
-    void heapifyUp(int index) {
+    // Records that heap[index] now holds its element
+    void place(size_t index) {
+        int h = handleOf(heap[index]);
+        if (h < 0) return;
+        if ((size_t)h >= positions.size()) positions.resize(h + 1, -1);
+        positions[h] = index;
+    }
+
+    void forget(const T& e) {
+        int h = handleOf(e);
+        if (h >= 0 && (size_t)h < positions.size()) positions[h] = -1;
+    }
+
+    void heapifyUp(size_t index) {
+        T item = std::move(heap[index]);
         while (index > 0) {
-            int parent = (index - 1) / 2;
-            if (heap[index].priority < heap[parent].priority) {
-                swap(heap[index], heap[parent]);
-                index = parent;
-            } else break;
+            size_t parent = (index - 1) / Arity;
+            if (!before(item, heap[parent])) break;
+            heap[index] = std::move(heap[parent]);
+            place(index);
+            index = parent;
         }
+        heap[index] = std::move(item);
+        place(index);
     }
 
-    void heapifyDown(int index) {
-        int size = heap.size();
+    void heapifyDown(size_t index) {
+        size_t size = heap.size();
+        T item = std::move(heap[index]);
         while (true) {
-            int left = 2 * index + 1;
-            int right = 2 * index + 2;
-            int smallest = index;
-
-            if (left < size && heap[left].priority < heap[smallest].priority)
-                smallest = left;
-            if (right < size && heap[right].priority < heap[smallest].priority)
-                smallest = right;
-
-            if (smallest != index) {
-                swap(heap[index], heap[smallest]);
-                index = smallest;
-            } else break;
+            size_t first = index * Arity + 1;
+            if (first >= size) break;
+            size_t last = first + Arity < size ? first + Arity : size;
+
+            size_t smallest = first;
+            for (size_t c = first + 1; c < last; c++)
+                if (before(heap[c], heap[smallest])) smallest = c;
+
+            if (!before(heap[smallest], item)) break;
+            heap[index] = std::move(heap[smallest]);
+            place(index);
+            index = smallest;
         }
+        heap[index] = std::move(item);
+        place(index);
     }
 
 public:
-    void insert(Patient p) {
-        heap.push_back(p);
+    explicit MinHeap(const KeyFn& fn = KeyFn(), const HandleFn& handleFn = HandleFn())
+        : keyOf(fn), handleOf(handleFn) {}
+
+    void insert(const T& e) {
+        heap.push_back(e);
         heapifyUp(heap.size() - 1);
     }
 
-    Patient extractMin() {
-        if (heap.empty())
-            return {-1, "None", 0, "", 3};
+    void insert(T&& e) {
+        heap.push_back(std::move(e));
+        heapifyUp(heap.size() - 1);
+    }
+
+    // Constructs the element in place
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        heap.emplace_back(std::forward<Args>(args)...);
+        heapifyUp(heap.size() - 1);
+    }
 
-        Patient minPatient = heap[0];
-        heap[0] = heap.back();
+    // Precondition: !isEmpty()
+    T extractMin() {
+        T minEntry = std::move(heap[0]);
+        forget(minEntry);
+        heap[0] = std::move(heap.back());
         heap.pop_back();
         if (!heap.empty()) heapifyDown(0);
-        return minPatient;
+        return minEntry;
+    }
+
+    // Precondition: !isEmpty()
+    const T& peek() const {
+        return heap[0];
+    }
+
+    // Replaces the contents with a bottom-up O(n) build, e.g. after
+    // re-keying for a new aging policy
+    void assign(const vector<T>& entries) {
+        for (const T& e : heap) forget(e);
+        heap = entries;
+        build();
+    }
+
+    void assign(vector<T>&& entries) {
+        for (const T& e : heap) forget(e);
+        heap = std::move(entries);
+        build();
+    }
+
+    // Adds a batch of k entries. Appending and rebuilding costs O(n + k),
+    // k inserts O(k log n); the cheaper one is used, so a mass intake is
+    // one heapify while a handful of arrivals still sift in one by one.
+    void merge(vector<T>&& batch) {
+        size_t total = heap.size() + batch.size();
+        size_t depth = 1;
+        for (size_t m = total; m >= (size_t)Arity; m /= Arity) depth++;
+        bool rebuild = batch.size() * depth >= total;
+
+        if (rebuild) heap.reserve(total);
+        for (T& e : batch) {
+            heap.push_back(std::move(e));
+            if (!rebuild) heapifyUp(heap.size() - 1);
+        }
+        batch.clear();
+        if (rebuild) build();
     }
 
-    Patient peek() const {
-        if (!heap.empty()) return heap[0];
-        return {-1, "None", 0, "", 3};
+    // Removes the entry at a position in getEntries(), O(log n)
+    void removeAt(size_t index) {
+        forget(heap[index]);
+        heap[index] = std::move(heap.back());
+        heap.pop_back();
+        if (index >= heap.size()) return;
+        resift(index);
+    }
+
+    // Position in getEntries() of the element with this handle, or -1; O(1)
+    int positionOf(int handle) const {
+        return handle >= 0 && (size_t)handle < positions.size() ? positions[handle] : -1;
+    }
+
+    // Re-sifts the entry at a position after its key changed, O(log n)
+    void resift(size_t index) {
+        if (index > 0 && before(heap[index], heap[(index - 1) / Arity]))
+            heapifyUp(index);
+        else
+            heapifyDown(index);
     }
 
-    const vector<Patient>& getPatients() const {
+    const vector<T>& getEntries() const {
         return heap;
     }
 
+    // Element at a position in getEntries(), for in-place edits followed
+    // by resift(); the handle must not change
+    T& at(size_t index) {
+        return heap[index];
+    }
+
+    int size() const {
+        return heap.size();
+    }
+
     bool isEmpty() const {
         return heap.empty();
     }
+
+    void clear() {
+        heap.clear();
+        positions.clear();
+    }
+
+private:
+    void build() {
+        for (size_t i = 0; i < heap.size(); i++) place(i);
+        if (heap.size() < 2) return;
+        for (size_t i = (heap.size() - 2) / Arity + 1; i-- > 0; )
+            heapifyDown(i);
+    }
 };
 
+// The emergency queue. Entries are 24 bytes, so a 4-ary node's children
+// span two cache lines; binary wins the pop-heavy mix (bench_heap_arity).
+// Indexed by record handle for deletion and retriage.
+typedef MinHeap<QueueEntry, QueueEntryKey, 2, QueueEntryHandle> EmergencyHeap;
+
 #endif
@@ -0,0 +1,353 @@
+#include "PatientArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+static const char FILE_MAGIC[4] = { 'H', 'C', 'A', '1' };
+static const unsigned int GROUP_MAGIC = 0x50524752; // "RGRP"
+
+// ---------------------------------------------------------------------------
+// Primitive encoders
+// ---------------------------------------------------------------------------
+
+static void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static int bitWidth(uint64_t maxValue) {
+    int w = 0;
+    while (maxValue) {
+        w++;
+        maxValue >>= 1;
+    }
+    return w;
+}
+
+// Packs `width`-bit values LSB first
+static void putPacked(string& out, const vector<uint32_t>& values, int width) {
+    out.push_back((char)width);
+    uint64_t acc = 0;
+    int bits = 0;
+    for (uint32_t v : values) {
+        acc |= (uint64_t)v << bits;
+        bits += width;
+        while (bits >= 8) {
+            out.push_back((char)(acc & 0xFF));
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+    if (bits > 0) out.push_back((char)acc);
+}
+
+static bool getPacked(const char*& p, const char* end, size_t count, vector<uint32_t>& values) {
+    if (p >= end) return false;
+    int width = (unsigned char)*p++;
+    if (width > 32) return false;
+    size_t bytes = (count * width + 7) / 8;
+    if ((size_t)(end - p) < bytes) return false;
+
+    values.resize(count);
+    uint64_t acc = 0;
+    int bits = 0;
+    uint64_t mask = width == 32 ? 0xFFFFFFFFull : ((1ull << width) - 1);
+    const unsigned char* q = (const unsigned char*)p;
+    for (size_t i = 0; i < count; i++) {
+        while (bits < width) {
+            acc |= (uint64_t)*q++ << bits;
+            bits += 8;
+        }
+        values[i] = (uint32_t)(acc & mask);
+        acc >>= width;
+        bits -= width;
+    }
+    p += bytes;
+    return true;
+}
+
+// Sorted dictionary with front coding, followed by bit-packed codes
+static void putDictionary(string& out, const vector<const string*>& column) {
+    vector<const string*> dict(column);
+    sort(dict.begin(), dict.end(), [](const string* a, const string* b) { return *a < *b; });
+    dict.erase(unique(dict.begin(), dict.end(), [](const string* a, const string* b) { return *a == *b; }),
+               dict.end());
+
+    putVarint(out, dict.size());
+    const string* prev = nullptr;
+    for (const string* s : dict) {
+        size_t shared = 0;
+        if (prev) {
+            size_t limit = min(prev->size(), s->size());
+            while (shared < limit && (*prev)[shared] == (*s)[shared]) shared++;
+        }
+        putVarint(out, shared);
+        putVarint(out, s->size() - shared);
+        out.append(*s, shared, string::npos);
+        prev = s;
+    }
+
+    vector<uint32_t> codes(column.size());
+    for (size_t i = 0; i < column.size(); i++) {
+        codes[i] = lower_bound(dict.begin(), dict.end(), column[i],
+                               [](const string* a, const string* b) { return *a < *b; }) - dict.begin();
+    }
+    putPacked(out, codes, bitWidth(dict.empty() ? 0 : dict.size() - 1));
+}
+
+static bool getDictionary(const char*& p, const char* end, size_t rows,
+                          vector<string>& dict, vector<uint32_t>& codes) {
+    uint64_t n;
+    if (!getVarint(p, end, n)) return false;
+    dict.resize(n);
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t shared, len;
+        if (!getVarint(p, end, shared) || !getVarint(p, end, len)) return false;
+        if ((uint64_t)(end - p) < len || (i > 0 && shared > dict[i - 1].size())) return false;
+        if (i > 0) dict[i].assign(dict[i - 1], 0, shared);
+        dict[i].append(p, len);
+        p += len;
+    }
+    if (!getPacked(p, end, rows, codes)) return false;
+    for (uint32_t c : codes)
+        if (c >= n) return false;
+    return true;
+}
+
+// Columns are length-prefixed so readers can jump over them
+static void putColumn(string& payload, const string& column) {
+    putVarint(payload, column.size());
+    payload += column;
+}
+
+static bool getColumn(const char*& p, const char* end, const char*& colBegin, const char*& colEnd) {
+    uint64_t len;
+    if (!getVarint(p, end, len) || (uint64_t)(end - p) < len) return false;
+    colBegin = p;
+    colEnd = p + len;
+    p = colEnd;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Row groups
+// ---------------------------------------------------------------------------
+
+void encodeRowGroup(const vector<PatientRecord>& rows, RowGroupHeader& header, string& payload) {
+    header.magic = GROUP_MAGIC;
+    header.rows = rows.size();
+    header.minID = INT_MAX;
+    header.maxID = INT_MIN;
+    header.minAdmitted = LLONG_MAX;
+    header.maxAdmitted = LLONG_MIN;
+    header.priorityMask = 0;
+    header.summary.clear();
+    payload.clear();
+
+    string col;
+    int64_t prev = 0;
+    for (const PatientRecord& r : rows) {
+        putVarint(col, zigzag((int64_t)r.patientID - prev));
+        prev = r.patientID;
+        header.minID = min(header.minID, r.patientID);
+        header.maxID = max(header.maxID, r.patientID);
+    }
+    putColumn(payload, col);
+
+    col.clear();
+    vector<uint32_t> values(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        int p = PatientColumns::clampPriority(rows[i].priorityLevel);
+        values[i] = p - 1;
+        header.priorityMask |= 1u << p;
+        header.summary.add(rows[i].age, rows[i].priorityLevel);
+    }
+    putPacked(col, values, 2);
+    putColumn(payload, col);
+
+    col.clear();
+    int minAge = INT_MAX, maxAge = INT_MIN;
+    for (const PatientRecord& r : rows) {
+        minAge = min(minAge, r.age);
+        maxAge = max(maxAge, r.age);
+    }
+    if (rows.empty()) minAge = maxAge = 0;
+    putVarint(col, zigzag(minAge));
+    for (size_t i = 0; i < rows.size(); i++) values[i] = (uint32_t)(rows[i].age - minAge);
+    putPacked(col, values, bitWidth((uint32_t)(maxAge - minAge)));
+    putColumn(payload, col);
+
+    col.clear();
+    prev = 0;
+    for (const PatientRecord& r : rows) {
+        putVarint(col, zigzag(r.admissionTime - prev));
+        prev = r.admissionTime;
+        header.minAdmitted = min(header.minAdmitted, r.admissionTime);
+        header.maxAdmitted = max(header.maxAdmitted, r.admissionTime);
+    }
+    putColumn(payload, col);
+
+    vector<const string*> text(rows.size());
+    col.clear();
+    for (size_t i = 0; i < rows.size(); i++) text[i] = &rows[i].name;
+    putDictionary(col, text);
+    putColumn(payload, col);
+
+    col.clear();
+    for (size_t i = 0; i < rows.size(); i++) text[i] = &rows[i].symptoms;
+    putDictionary(col, text);
+    putColumn(payload, col);
+
+    header.payloadBytes = payload.size();
+}
+
+static bool getIDs(const char*& p, const char* end, size_t rows, vector<int>& ids) {
+    const char* cb;
+    const char* ce;
+    ids.resize(rows);
+    if (!getColumn(p, end, cb, ce)) return false;
+    int64_t prev = 0;
+    for (size_t i = 0; i < rows; i++) {
+        uint64_t v;
+        if (!getVarint(cb, ce, v)) return false;
+        prev += unzigzag(v);
+        ids[i] = (int)prev;
+    }
+    return true;
+}
+
+bool decodeRowGroupIDs(const RowGroupHeader& header, const string& payload, vector<int>& ids) {
+    const char* p = payload.data();
+    return getIDs(p, p + payload.size(), header.rows, ids);
+}
+
+bool decodeRowGroup(const RowGroupHeader& header, const string& payload,
+                    const ArchiveFilter& filter, vector<PatientRecord>& out) {
+    const char* p = payload.data();
+    const char* end = p + payload.size();
+    const char* cb;
+    const char* ce;
+    size_t rows = header.rows;
+
+    // ID and priority first; the rest is only decoded if some row matches
+    vector<int> ids;
+    if (!getIDs(p, end, rows, ids)) return false;
+
+    vector<uint32_t> priorities;
+    if (!getColumn(p, end, cb, ce) || !getPacked(cb, ce, rows, priorities)) return false;
+
+    vector<size_t> matched;
+    for (size_t i = 0; i < rows; i++) {
+        if (filter.matches(ids[i], priorities[i] + 1)) matched.push_back(i);
+    }
+    if (matched.empty()) return true;
+
+    vector<uint32_t> ages;
+    uint64_t minAge;
+    if (!getColumn(p, end, cb, ce) || !getVarint(cb, ce, minAge) || !getPacked(cb, ce, rows, ages))
+        return false;
+
+    vector<long long> admitted(rows);
+    if (!getColumn(p, end, cb, ce)) return false;
+    int64_t prev = 0;
+    for (size_t i = 0; i < rows; i++) {
+        uint64_t v;
+        if (!getVarint(cb, ce, v)) return false;
+        prev += unzigzag(v);
+        admitted[i] = prev;
+    }
+
+    vector<string> names, symptoms;
+    vector<uint32_t> nameCodes, symptomCodes;
+    if (!getColumn(p, end, cb, ce) || !getDictionary(cb, ce, rows, names, nameCodes)) return false;
+    if (!getColumn(p, end, cb, ce) || !getDictionary(cb, ce, rows, symptoms, symptomCodes)) return false;
+
+    int ageBase = (int)unzigzag(minAge);
+    for (size_t i : matched) {
+        PatientRecord r;
+        r.patientID = ids[i];
+        r.priorityLevel = priorities[i] + 1;
+        r.age = ageBase + (int)ages[i];
+        r.admissionTime = admitted[i];
+        r.name = names[nameCodes[i]];
+        r.symptoms = symptoms[symptomCodes[i]];
+        out.push_back(r);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Files
+// ---------------------------------------------------------------------------
+
+bool archiveWriteMagic(ostream& out) {
+    out.write(FILE_MAGIC, 4);
+    return (bool)out;
+}
+
+bool archiveCheckMagic(istream& in) {
+    char magic[4];
+    return in.read(magic, 4) && memcmp(magic, FILE_MAGIC, 4) == 0;
+}
+
+bool archiveReadHeader(istream& in, RowGroupHeader& header) {
+    return in.read((char*)&header, sizeof(header)) && header.magic == GROUP_MAGIC;
+}
+
+bool archiveWriteGroup(ostream& out, const RowGroupHeader& header, const string& payload) {
+    out.write((const char*)&header, sizeof(header));
+    out.write(payload.data(), payload.size());
+    return (bool)out;
+}
+
+bool ArchiveScanner::open(const string& filename, const ArchiveFilter& f) {
+    file.open(filename, ios::binary);
+    filter = f;
+    buffer.clear();
+    pos = 0;
+    groupsRead = groupsSkipped = 0;
+    return file.is_open() && archiveCheckMagic(file);
+}
+
+bool ArchiveScanner::next(PatientRecord& out) {
+    while (pos >= buffer.size()) {
+        buffer.clear();
+        pos = 0;
+
+        RowGroupHeader h;
+        if (!archiveReadHeader(file, h)) return false;
+        if (!filter.mayMatch(h)) {
+            file.seekg(h.payloadBytes, ios::cur);
+            groupsSkipped++;
+            continue;
+        }
+
+        string payload(h.payloadBytes, '\0');
+        if (h.payloadBytes > 0 && !file.read(&payload[0], h.payloadBytes)) return false;
+        groupsRead++;
+        if (!decodeRowGroup(h, payload, filter, buffer)) return false;
+    }
+    out = buffer[pos++];
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef PATIENT_ARCHIVE_H
+#define PATIENT_ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <climits>
+#include <fstream>
+#include "PatientColumns.h"
+
+using namespace std;
+
+// Self-contained copy of a record that owns its text. Used for records
+// that may come from disk instead of the in-memory store.
+struct PatientRecord {
+    int patientID;
+    string name;
+    int age;
+    string symptoms;
+    int priorityLevel;
+    long long admissionTime;
+
+    PatientRecord() : patientID(-1), age(0), priorityLevel(3), admissionTime(0) {}
+};
+
+// Compressed columnar archive for historical records.
+//
+// File: "HCA1" magic followed by row groups. Each row group is a fixed
+// header with min/max statistics, then one payload holding the columns:
+//   IDs        zigzag varint of the first ID, then varint deltas
+//   priority   2-bit packed
+//   age        frame of reference + bit packed
+//   admission  zigzag varint deltas
+//   name       sorted, front-coded dictionary + bit-packed codes
+//   symptoms   same as name
+// Every column is prefixed with its byte length so a reader can skip it.
+
+const int ARCHIVE_ROW_GROUP = 4096;
+
+struct RowGroupHeader {
+    unsigned int magic;
+    unsigned int rows;
+    int minID;
+    int maxID;
+    long long minAdmitted;
+    long long maxAdmitted;
+    unsigned int priorityMask;   // bit p set if priority p occurs
+    unsigned int payloadBytes;
+    RetiredSummary summary;      // age band x priority counts for analytics
+};
+
+// Row filter; row groups whose statistics cannot match are skipped unread
+struct ArchiveFilter {
+    int minID;
+    int maxID;
+    unsigned int priorityMask;
+
+    ArchiveFilter() : minID(INT_MIN), maxID(INT_MAX), priorityMask(0xE) {}
+
+    bool mayMatch(const RowGroupHeader& h) const {
+        return h.maxID >= minID && h.minID <= maxID && (h.priorityMask & priorityMask) != 0;
+    }
+    bool matches(int id, int priority) const {
+        return id >= minID && id <= maxID && (priorityMask & (1u << priority)) != 0;
+    }
+};
+
+// Encodes rows (sorted by ID for best compression) into one row group
+void encodeRowGroup(const vector<PatientRecord>& rows, RowGroupHeader& header, string& payload);
+// Appends the rows of a row group that pass the filter
+bool decodeRowGroup(const RowGroupHeader& header, const string& payload,
+                    const ArchiveFilter& filter, vector<PatientRecord>& out);
+// Only the ID column, in row order (ascending)
+bool decodeRowGroupIDs(const RowGroupHeader& header, const string& payload, vector<int>& ids);
+
+// Streaming scanner: reads one row group at a time, skipping groups the
+// filter rules out by seeking past them
+class ArchiveScanner {
+private:
+    ifstream file;
+    ArchiveFilter filter;
+    vector<PatientRecord> buffer;
+    size_t pos;
+
+public:
+    int groupsRead;
+    int groupsSkipped;
+
+    ArchiveScanner() : pos(0), groupsRead(0), groupsSkipped(0) {}
+
+    bool open(const string& filename, const ArchiveFilter& f = ArchiveFilter());
+    bool next(PatientRecord& out);
+};
+
+// File helpers shared with ColdStore, which appends row groups
+bool archiveWriteMagic(ostream& out);
+bool archiveCheckMagic(istream& in);
+bool archiveReadHeader(istream& in, RowGroupHeader& header);
+bool archiveWriteGroup(ostream& out, const RowGroupHeader& header, const string& payload);
+
+#endif
@@ -0,0 +1,343 @@
+#include "PatientColumns.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_KERNELS
+#endif
+
+const uint8_t PatientColumns::EMPTY_CELL;
+
+int PatientColumns::ageBand(int age) {
+    if (age < 18) return 0;
+    if (age < 35) return 1;
+    if (age < 50) return 2;
+    if (age < 65) return 3;
+    if (age < 80) return 4;
+    return 5;
+}
+
+int PatientColumns::clampPriority(int priority) {
+    if (priority < 1) return 1;
+    if (priority > PRIORITY_LEVELS) return PRIORITY_LEVELS;
+    return priority;
+}
+
+uint8_t PatientColumns::cellFor(int age, int priority, bool waiting) {
+    return (waiting ? AGE_BANDS * PRIORITY_LEVELS : 0)
+         + ageBand(age) * PRIORITY_LEVELS + (clampPriority(priority) - 1);
+}
+
+void RetiredSummary::clear() {
+    for (int b = 0; b < AGE_BANDS; b++)
+        for (int p = 0; p < PRIORITY_LEVELS; p++) histogram[b][p] = 0;
+    for (int p = 0; p < PRIORITY_LEVELS; p++) ageSums[p] = counts[p] = 0;
+}
+
+void RetiredSummary::add(int age, int priority) {
+    int p = PatientColumns::clampPriority(priority) - 1;
+    histogram[PatientColumns::ageBand(age)][p]++;
+    ageSums[p] += age;
+    counts[p]++;
+}
+
+void RetiredSummary::merge(const RetiredSummary& other) {
+    for (int b = 0; b < AGE_BANDS; b++)
+        for (int p = 0; p < PRIORITY_LEVELS; p++) histogram[b][p] += other.histogram[b][p];
+    for (int p = 0; p < PRIORITY_LEVELS; p++) {
+        ageSums[p] += other.ageSums[p];
+        counts[p] += other.counts[p];
+    }
+}
+
+const char* PatientColumns::ageBandLabel(int band) {
+    static const char* labels[AGE_BANDS] = { "0-17", "18-34", "35-49", "50-64", "65-79", "80+" };
+    if (band < 0 || band >= AGE_BANDS) return "";
+    return labels[band];
+}
+
+void PatientColumns::set(int handle, int id, int age, int priority, long long admittedAt, bool waiting) {
+    if (handle < 0) return;
+    size_t h = handle;
+    if (h >= ids.size()) {
+        ids.resize(h + 1, 0);
+        ages.resize(h + 1, 0);
+        priorities.resize(h + 1, 0);
+        admitted.resize(h + 1, 0);
+        cells.resize(h + 1, EMPTY_CELL);
+    }
+    ids[h] = id;
+    ages[h] = age;
+    priorities[h] = priority;
+    admitted[h] = admittedAt;
+    cells[h] = cellFor(age, priority, waiting);
+}
+
+void PatientColumns::setWaiting(int handle, bool waiting) {
+    if (handle < 0 || handle >= (int)ids.size() || cells[handle] == EMPTY_CELL) return;
+    cells[handle] = cellFor(ages[handle], priorities[handle], waiting);
+}
+
+void PatientColumns::retire(int handle) {
+    if (handle < 0 || handle >= (int)ids.size() || cells[handle] == EMPTY_CELL) return;
+    retired.add(ages[handle], priorities[handle]);
+    // Priority 0 keeps the slot out of the age sums as well
+    priorities[handle] = 0;
+    cells[handle] = EMPTY_CELL;
+}
+
+void PatientColumns::remove(int handle) {
+    if (handle < 0 || handle >= (int)ids.size()) return;
+    priorities[handle] = 0;
+    cells[handle] = EMPTY_CELL;
+}
+
+bool PatientColumns::isWaiting(int handle) const {
+    if (handle < 0 || handle >= (int)ids.size()) return false;
+    return cells[handle] >= AGE_BANDS * PRIORITY_LEVELS && cells[handle] < CELLS;
+}
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+static void countCellsScalar(const uint8_t* cells, size_t n, uint64_t totals[CELLS]) {
+    // Four sub-histograms hide the store-to-load dependency on repeated keys
+    uint32_t h[4][CELLS] = {{0}};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        if (cells[i] < CELLS) h[0][cells[i]]++;
+        if (cells[i + 1] < CELLS) h[1][cells[i + 1]]++;
+        if (cells[i + 2] < CELLS) h[2][cells[i + 2]]++;
+        if (cells[i + 3] < CELLS) h[3][cells[i + 3]]++;
+    }
+    for (; i < n; i++)
+        if (cells[i] < CELLS) h[0][cells[i]]++;
+    for (int k = 0; k < CELLS; k++)
+        totals[k] += (uint64_t)h[0][k] + h[1][k] + h[2][k] + h[3][k];
+}
+
+static void sumAgeScalar(const int32_t* ages, const int32_t* priorities, size_t n,
+                         int64_t sums[PRIORITY_LEVELS], int64_t counts[PRIORITY_LEVELS]) {
+    for (size_t i = 0; i < n; i++) {
+        int p = priorities[i] - 1;
+        if (p < 0 || p >= PRIORITY_LEVELS) continue;
+        sums[p] += ages[i];
+        counts[p]++;
+    }
+}
+
+// Byte counters are compared against 12 keys at a time and flushed every
+// 255 vectors, before they can overflow. Blocks are small enough to stay in
+// L1 across the three key groups.
+// The key loop must be unrolled for the accumulators to live in registers.
+static const int KEY_GROUP = 12;
+#if defined(__GNUC__) && !defined(__clang__)
+#define UNROLL_KEYS _Pragma("GCC unroll 12")
+#else
+#define UNROLL_KEYS
+#endif
+
+#ifdef HAVE_SSE2_KERNELS
+static size_t countCellsSSE2(const uint8_t* cells, size_t n, uint64_t totals[CELLS]) {
+    const size_t W = 16;
+    const size_t BLOCK = 255 * W;
+    size_t i = 0;
+    while (n - i >= W) {
+        size_t end = i + std::min(BLOCK, (n - i) / W * W);
+        for (int k0 = 0; k0 < CELLS; k0 += KEY_GROUP) {
+            __m128i acc[KEY_GROUP];
+            for (int g = 0; g < KEY_GROUP; g++) acc[g] = _mm_setzero_si128();
+            for (size_t j = i; j < end; j += W) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(cells + j));
+                UNROLL_KEYS
+                for (int g = 0; g < KEY_GROUP; g++)
+                    acc[g] = _mm_sub_epi8(acc[g], _mm_cmpeq_epi8(v, _mm_set1_epi8((char)(k0 + g))));
+            }
+            for (int g = 0; g < KEY_GROUP; g++) {
+                __m128i s = _mm_sad_epu8(acc[g], _mm_setzero_si128());
+                totals[k0 + g] += (uint64_t)_mm_cvtsi128_si32(s)
+                                + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+            }
+        }
+        i = end;
+    }
+    return i;
+}
+
+static size_t sumAgeSSE2(const int32_t* ages, const int32_t* priorities, size_t n,
+                         int64_t sums[PRIORITY_LEVELS], int64_t counts[PRIORITY_LEVELS]) {
+    const size_t W = 4;
+    const size_t BLOCK = (1 << 20) * W; // 32-bit lane sums cannot overflow within a block
+    size_t i = 0;
+    while (n - i >= W) {
+        size_t end = i + std::min(BLOCK, (n - i) / W * W);
+        __m128i s[PRIORITY_LEVELS], c[PRIORITY_LEVELS];
+        for (int p = 0; p < PRIORITY_LEVELS; p++) {
+            s[p] = _mm_setzero_si128();
+            c[p] = _mm_setzero_si128();
+        }
+        for (size_t j = i; j < end; j += W) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(ages + j));
+            __m128i pr = _mm_loadu_si128((const __m128i*)(priorities + j));
+            for (int p = 0; p < PRIORITY_LEVELS; p++) {
+                __m128i m = _mm_cmpeq_epi32(pr, _mm_set1_epi32(p + 1));
+                s[p] = _mm_add_epi32(s[p], _mm_and_si128(m, a));
+                c[p] = _mm_sub_epi32(c[p], m);
+            }
+        }
+        for (int p = 0; p < PRIORITY_LEVELS; p++) {
+            int32_t sv[4], cv[4];
+            _mm_storeu_si128((__m128i*)sv, s[p]);
+            _mm_storeu_si128((__m128i*)cv, c[p]);
+            for (int k = 0; k < 4; k++) {
+                sums[p] += (uint32_t)sv[k];
+                counts[p] += (uint32_t)cv[k];
+            }
+        }
+        i = end;
+    }
+    return i;
+}
+#endif
+
+#ifdef HAVE_AVX2_KERNELS
+__attribute__((target("avx2")))
+static size_t countCellsAVX2(const uint8_t* cells, size_t n, uint64_t totals[CELLS]) {
+    const size_t W = 32;
+    const size_t BLOCK = 255 * W;
+    size_t i = 0;
+    while (n - i >= W) {
+        size_t end = i + std::min(BLOCK, (n - i) / W * W);
+        for (int k0 = 0; k0 < CELLS; k0 += KEY_GROUP) {
+            __m256i acc[KEY_GROUP];
+            for (int g = 0; g < KEY_GROUP; g++) acc[g] = _mm256_setzero_si256();
+            for (size_t j = i; j < end; j += W) {
+                __m256i v = _mm256_loadu_si256((const __m256i*)(cells + j));
+                UNROLL_KEYS
+                for (int g = 0; g < KEY_GROUP; g++)
+                    acc[g] = _mm256_sub_epi8(acc[g], _mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)(k0 + g))));
+            }
+            for (int g = 0; g < KEY_GROUP; g++) {
+                __m256i s = _mm256_sad_epu8(acc[g], _mm256_setzero_si256());
+                uint64_t lanes[4];
+                _mm256_storeu_si256((__m256i*)lanes, s);
+                totals[k0 + g] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            }
+        }
+        i = end;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t sumAgeAVX2(const int32_t* ages, const int32_t* priorities, size_t n,
+                         int64_t sums[PRIORITY_LEVELS], int64_t counts[PRIORITY_LEVELS]) {
+    const size_t W = 8;
+    const size_t BLOCK = (1 << 20) * W;
+    size_t i = 0;
+    while (n - i >= W) {
+        size_t end = i + std::min(BLOCK, (n - i) / W * W);
+        __m256i s[PRIORITY_LEVELS], c[PRIORITY_LEVELS];
+        for (int p = 0; p < PRIORITY_LEVELS; p++) {
+            s[p] = _mm256_setzero_si256();
+            c[p] = _mm256_setzero_si256();
+        }
+        for (size_t j = i; j < end; j += W) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(ages + j));
+            __m256i pr = _mm256_loadu_si256((const __m256i*)(priorities + j));
+            for (int p = 0; p < PRIORITY_LEVELS; p++) {
+                __m256i m = _mm256_cmpeq_epi32(pr, _mm256_set1_epi32(p + 1));
+                s[p] = _mm256_add_epi32(s[p], _mm256_and_si256(m, a));
+                c[p] = _mm256_sub_epi32(c[p], m);
+            }
+        }
+        for (int p = 0; p < PRIORITY_LEVELS; p++) {
+            int32_t sv[8], cv[8];
+            _mm256_storeu_si256((__m256i*)sv, s[p]);
+            _mm256_storeu_si256((__m256i*)cv, c[p]);
+            for (int k = 0; k < 8; k++) {
+                sums[p] += (uint32_t)sv[k];
+                counts[p] += (uint32_t)cv[k];
+            }
+        }
+        i = end;
+    }
+    return i;
+}
+
+static bool cpuHasAVX2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+#endif
+
+const char* PatientColumns::kernelName() {
+#ifdef HAVE_AVX2_KERNELS
+    if (cpuHasAVX2()) return "AVX2";
+#endif
+#ifdef HAVE_SSE2_KERNELS
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void countCells(const uint8_t* cells, size_t n, uint32_t out[CELLS]) {
+    uint64_t totals[CELLS] = {0};
+    size_t done = 0;
+#ifdef HAVE_AVX2_KERNELS
+    if (cpuHasAVX2()) done = countCellsAVX2(cells, n, totals);
+#endif
+#ifdef HAVE_SSE2_KERNELS
+    if (done == 0) done = countCellsSSE2(cells, n, totals);
+#endif
+    countCellsScalar(cells + done, n - done, totals);
+    for (int k = 0; k < CELLS; k++) out[k] = (uint32_t)totals[k];
+}
+
+void sumAgeByPriority(const int32_t* ages, const int32_t* priorities, size_t n,
+                      int64_t sums[PRIORITY_LEVELS], int64_t counts[PRIORITY_LEVELS]) {
+    for (int p = 0; p < PRIORITY_LEVELS; p++) sums[p] = counts[p] = 0;
+    size_t done = 0;
+#ifdef HAVE_AVX2_KERNELS
+    if (cpuHasAVX2()) done = sumAgeAVX2(ages, priorities, n, sums, counts);
+#endif
+#ifdef HAVE_SSE2_KERNELS
+    if (done == 0) done = sumAgeSSE2(ages, priorities, n, sums, counts);
+#endif
+    sumAgeScalar(ages + done, priorities + done, n - done, sums, counts);
+}
+
+DashboardStats PatientColumns::computeStats() const {
+    DashboardStats st;
+    uint32_t out[CELLS];
+    countCells(cells.data(), cells.size(), out);
+
+    const int waitingBase = AGE_BANDS * PRIORITY_LEVELS;
+    st.total = 0;
+    st.totalWaiting = 0;
+    for (int b = 0; b < AGE_BANDS; b++) {
+        for (int p = 0; p < PRIORITY_LEVELS; p++) {
+            int k = b * PRIORITY_LEVELS + p;
+            st.waiting[b][p] = out[waitingBase + k];
+            st.histogram[b][p] = out[k] + out[waitingBase + k] + retired.histogram[b][p];
+            st.totalWaiting += out[waitingBase + k];
+            st.total += st.histogram[b][p];
+        }
+    }
+
+    int64_t sums[PRIORITY_LEVELS], counts[PRIORITY_LEVELS];
+    sumAgeByPriority(ages.data(), priorities.data(), ages.size(), sums, counts);
+    for (int p = 0; p < PRIORITY_LEVELS; p++) {
+        sums[p] += retired.ageSums[p];
+        counts[p] += retired.counts[p];
+        st.perPriority[p] = (uint32_t)counts[p];
+        st.avgAge[p] = counts[p] ? (double)sums[p] / counts[p] : 0.0;
+    }
+    return st;
+}
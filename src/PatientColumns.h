@@ -0,0 +1,84 @@
+#ifndef PATIENT_COLUMNS_H
+#define PATIENT_COLUMNS_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+using namespace std;
+
+// Age bands used by the dashboard histogram
+const int AGE_BANDS = 6;   // 0-17, 18-34, 35-49, 50-64, 65-79, 80+
+const int PRIORITY_LEVELS = 3;
+const int CELLS = 2 * AGE_BANDS * PRIORITY_LEVELS; // x2 for waiting/treated
+
+struct DashboardStats {
+    uint32_t histogram[AGE_BANDS][PRIORITY_LEVELS]; // all patients
+    uint32_t waiting[AGE_BANDS][PRIORITY_LEVELS];   // waiting patients only
+    double avgAge[PRIORITY_LEVELS];
+    uint32_t perPriority[PRIORITY_LEVELS];
+    uint32_t total;
+    uint32_t totalWaiting;
+};
+
+// Aggregate of records that left memory (treated and moved to the cold tier)
+struct RetiredSummary {
+    uint32_t histogram[AGE_BANDS][PRIORITY_LEVELS];
+    int64_t ageSums[PRIORITY_LEVELS];
+    int64_t counts[PRIORITY_LEVELS];
+
+    RetiredSummary() { clear(); }
+    void clear();
+    void add(int age, int priority);
+    void merge(const RetiredSummary& other);
+};
+
+// Column-oriented (SoA) mirror of the record store, indexed by the same
+// handles. Kept contiguous so the dashboard aggregations can be vectorized.
+class PatientColumns {
+private:
+    vector<int32_t> ids;
+    vector<int32_t> ages;
+    vector<int32_t> priorities;
+    vector<int64_t> admitted;
+    // Precomputed histogram cell per record:
+    // waiting * 18 + ageBand * 3 + (priority - 1)
+    // EMPTY_CELL marks slots freed by retire()
+    vector<uint8_t> cells;
+    RetiredSummary retired;
+
+    static uint8_t cellFor(int age, int priority, bool waiting);
+
+public:
+    static const uint8_t EMPTY_CELL = 0xFF;
+
+    void set(int handle, int id, int age, int priority, long long admittedAt, bool waiting);
+    void setWaiting(int handle, bool waiting);
+    // Move a slot's record into the retired summary and free the slot
+    void retire(int handle);
+    void addRetired(const RetiredSummary& summary) { retired.merge(summary); }
+    void setRetired(const RetiredSummary& summary) { retired = summary; }
+    // Free a slot whose record was deleted; it counts nowhere
+    void remove(int handle);
+    bool isWaiting(int handle) const;
+
+    size_t size() const { return ids.size(); }
+    const int32_t* idColumn() const { return ids.data(); }
+    const int32_t* ageColumn() const { return ages.data(); }
+    const int32_t* priorityColumn() const { return priorities.data(); }
+    const int64_t* admittedColumn() const { return admitted.data(); }
+
+    DashboardStats computeStats() const;
+
+    static int ageBand(int age);
+    static int clampPriority(int priority);
+    static const char* ageBandLabel(int band);
+    static const char* kernelName();
+};
+
+// Aggregation kernels (AVX2 / SSE2 / scalar, chosen at runtime)
+void countCells(const uint8_t* cells, size_t n, uint32_t out[CELLS]);
+void sumAgeByPriority(const int32_t* ages, const int32_t* priorities, size_t n,
+                      int64_t sums[PRIORITY_LEVELS], int64_t counts[PRIORITY_LEVELS]);
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef PATIENT_ID_INDEX_H
+#define PATIENT_ID_INDEX_H
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// Hash index on patient ID -> record handle, kept beside the ordered BST.
+// Open addressing with Robin Hood probing over a flat array of 8-byte slots:
+// a lookup usually stays within one cache line, and a miss stops as soon as
+// it reaches a slot that is closer to its own home than the key would be.
+// Erase shifts the following run back, so there are no tombstones.
+class PatientIDIndex {
+private:
+    struct Slot {
+        int id;
+        int handle; // -1 = empty
+    };
+
+    vector<Slot> slots;
+    size_t count;
+    unsigned int shift; // 32 - log2(capacity)
+
+    size_t homeOf(int id) const {
+        return (unsigned int)id * 2654435769u >> shift; // Fibonacci hashing
+    }
+
+    size_t distance(size_t pos, int id) const {
+        return (pos - homeOf(id)) & (slots.size() - 1);
+    }
+
+    void rehash(size_t capacity) {
+        vector<Slot> old;
+        old.swap(slots);
+        Slot empty = { 0, -1 };
+        slots.assign(capacity, empty);
+        shift = 32;
+        for (size_t c = capacity; c > 1; c >>= 1) shift--;
+        count = 0;
+        for (const Slot& s : old)
+            if (s.handle >= 0) insert(s.id, s.handle);
+    }
+
+public:
+    PatientIDIndex() : count(0), shift(0) { rehash(16); }
+
+    // Handle for id, or -1
+    int find(int id) const {
+        size_t mask = slots.size() - 1;
+        size_t pos = homeOf(id);
+        for (size_t dist = 0; ; dist++, pos = (pos + 1) & mask) {
+            const Slot& s = slots[pos];
+            if (s.handle < 0 || distance(pos, s.id) < dist) return -1;
+            if (s.id == id) return s.handle;
+        }
+    }
+
+    // Returns false if id is already present
+    bool insert(int id, int handle) {
+        // Keep load factor under 80%
+        if ((count + 1) * 5 > slots.size() * 4) rehash(slots.size() * 2);
+
+        size_t mask = slots.size() - 1;
+        size_t pos = homeOf(id);
+        Slot carry = { id, handle };
+        bool displaced = false;
+        for (size_t dist = 0; ; dist++, pos = (pos + 1) & mask) {
+            Slot& s = slots[pos];
+            if (s.handle < 0) {
+                s = carry;
+                count++;
+                return true;
+            }
+            if (!displaced && s.id == id) return false;
+
+            // Take the slot from an entry that is nearer its home
+            size_t existing = distance(pos, s.id);
+            if (existing < dist) {
+                Slot tmp = s;
+                s = carry;
+                carry = tmp;
+                dist = existing;
+                displaced = true;
+            }
+        }
+    }
+
+    bool erase(int id) {
+        size_t mask = slots.size() - 1;
+        size_t pos = homeOf(id);
+        for (size_t dist = 0; ; dist++, pos = (pos + 1) & mask) {
+            Slot& s = slots[pos];
+            if (s.handle < 0 || distance(pos, s.id) < dist) return false;
+            if (s.id == id) break;
+        }
+
+        // Backward shift: pull the rest of the run one slot closer to home
+        size_t next = (pos + 1) & mask;
+        while (slots[next].handle >= 0 && distance(next, slots[next].id) > 0) {
+            slots[pos] = slots[next];
+            pos = next;
+            next = (next + 1) & mask;
+        }
+        slots[pos].handle = -1;
+        count--;
+        return true;
+    }
+
+    // Sizes the table for n entries up front (bulk loads)
+    void reserve(size_t n) {
+        size_t capacity = slots.size();
+        while (n * 5 > capacity * 4) capacity *= 2;
+        if (capacity != slots.size()) rehash(capacity);
+    }
+
+    size_t size() const { return count; }
+    size_t memoryUsage() const { return slots.capacity() * sizeof(Slot); }
+};
+
+#endif
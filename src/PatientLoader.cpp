@@ -0,0 +1,212 @@
+#include "PatientLoader.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+PatientLoader::PatientLoader()
+    : cancelled(false), finished(true), skipped(0), bytesRead(0), totalBytes(0) {}
+
+PatientLoader::~PatientLoader() {
+    {
+        lock_guard<mutex> guard(lock);
+        cancelled = true;
+    }
+    space.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+bool PatientLoader::start(const string& filename) {
+    ifstream probe(filename, ios::binary | ios::ate);
+    if (!probe.is_open()) return false;
+    totalBytes = probe.tellg();
+    probe.close();
+
+    finished = false;
+    worker = thread(&PatientLoader::run, this, filename);
+    return true;
+}
+
+void PatientLoader::run(string filename) {
+    ifstream file(filename);
+    string line;
+    readRecord(file, line); // Skip header
+    long long consumed = line.size() + 1;
+
+    const size_t BATCH = 1024;
+    vector<PatientRecord> batch;
+    batch.reserve(BATCH);
+    bool more = true;
+    while (more) {
+        more = readRecord(file, line);
+        if (more) {
+            consumed += line.size() + 1;
+            PatientRecord r;
+            if (parseLine(line, r)) batch.push_back(std::move(r));
+            else if (line.find_first_not_of("\r") != string::npos) skipped++;
+            if (batch.size() < BATCH) continue;
+        }
+
+        unique_lock<mutex> guard(lock);
+        space.wait(guard, [this] { return cancelled || pending.size() < MAX_PENDING; });
+        if (cancelled) break;
+        for (PatientRecord& r : batch) pending.push_back(std::move(r));
+        batch.clear();
+        bytesRead = consumed;
+    }
+    bytesRead = totalBytes;
+    finished = true;
+}
+
+size_t PatientLoader::take(vector<PatientRecord>& out, size_t maxRows) {
+    out.clear();
+    {
+        lock_guard<mutex> guard(lock);
+        size_t n = pending.size() < maxRows ? pending.size() : maxRows;
+        // Hand out the oldest rows first so file order is preserved
+        out.assign(make_move_iterator(pending.begin()), make_move_iterator(pending.begin() + n));
+        pending.erase(pending.begin(), pending.begin() + n);
+    }
+    space.notify_one();
+    return out.size();
+}
+
+bool PatientLoader::done() {
+    if (!finished) return false;
+    lock_guard<mutex> guard(lock);
+    return pending.empty();
+}
+
+float PatientLoader::progress() const {
+    if (totalBytes <= 0) return 1.0f;
+    return (float)bytesRead / (float)totalBytes;
+}
+
+int PatientLoader::scanMaxID(const string& filename) {
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (!f) return 0;
+
+    static const size_t BLOCK = 1 << 20;
+    vector<char> buf(BLOCK);
+    int maxID = 0;
+    bool header = true;
+    bool lineStart = false;
+    long long value = 0;
+    bool inNumber = false;
+    bool quoted = false; // newlines in quoted fields do not end the record
+
+    size_t n;
+    while ((n = fread(buf.data(), 1, BLOCK, f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            char c = buf[i];
+            if (c == '"') quoted = !quoted;
+            if (c == '\n' && !quoted) {
+                if (inNumber && value > maxID) maxID = (int)value;
+                header = false;
+                lineStart = true;
+                inNumber = false;
+                continue;
+            }
+            if (header) continue;
+            if (lineStart && c >= '0' && c <= '9') {
+                inNumber = true;
+                lineStart = false;
+                value = c - '0';
+            } else if (inNumber && c >= '0' && c <= '9') {
+                if (value < 0x7FFFFFFF) value = value * 10 + (c - '0');
+            } else {
+                if (inNumber && value > maxID) maxID = (int)value;
+                lineStart = false;
+                inNumber = false;
+            }
+        }
+    }
+    if (inNumber && value > maxID) maxID = (int)value;
+    fclose(f);
+    return maxID;
+}
+
+static bool nextField(const string& line, size_t& pos, string& field) {
+    if (pos > line.size()) return false;
+    if (pos < line.size() && line[pos] == '"') {
+        // Quoted: "" is a literal quote, and the closing quote must end
+        // the field
+        field.clear();
+        size_t i = pos + 1;
+        for (;;) {
+            size_t quote = line.find('"', i);
+            if (quote == string::npos) return false;
+            field.append(line, i, quote - i);
+            if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                field += '"';
+                i = quote + 2;
+                continue;
+            }
+            size_t after = quote + 1;
+            if (after == line.size() || line[after] == '\r') pos = line.size() + 1;
+            else if (line[after] == ',') pos = after + 1;
+            else return false;
+            return true;
+        }
+    }
+    size_t comma = line.find(',', pos);
+    if (comma == string::npos) comma = line.size();
+    field.assign(line, pos, comma - pos);
+    pos = comma + 1;
+    return true;
+}
+
+static bool toNumber(const string& field, long long& out) {
+    if (field.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    out = strtoll(field.c_str(), &end, 10);
+    return errno == 0 && (*end == '\0' || *end == '\r');
+}
+
+bool PatientLoader::parseLine(const string& line, PatientRecord& out) {
+    size_t pos = 0;
+    string field;
+    long long value;
+
+    if (!nextField(line, pos, field) || !toNumber(field, value)) return false;
+    out.patientID = (int)value;
+    if (!nextField(line, pos, out.name)) return false;
+    if (!nextField(line, pos, field) || !toNumber(field, value)) return false;
+    out.age = (int)value;
+    if (!nextField(line, pos, out.symptoms)) return false;
+    if (!nextField(line, pos, field) || !toNumber(field, value)) return false;
+    out.priorityLevel = (int)value;
+
+    out.admissionTime = 0;
+    if (nextField(line, pos, field) && toNumber(field, value)) out.admissionTime = value;
+    return true;
+}
+
+bool PatientLoader::readRecord(istream& in, string& record) {
+    if (!getline(in, record)) return false;
+    size_t quotes = count(record.begin(), record.end(), '"');
+    string more;
+    while (quotes % 2 == 1 && getline(in, more)) {
+        record += '\n';
+        record += more;
+        quotes += count(more.begin(), more.end(), '"');
+    }
+    return true;
+}
+
+void PatientLoader::writeField(ostream& out, const char* field) {
+    if (!strpbrk(field, ",\"\r\n")) {
+        out << field;
+        return;
+    }
+    out << '"';
+    for (const char* c = field; *c; c++) {
+        if (*c == '"') out << '"';
+        out << *c;
+    }
+    out << '"';
+}
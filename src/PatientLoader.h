@@ -0,0 +1,68 @@
+#ifndef PATIENT_LOADER_H
+#define PATIENT_LOADER_H
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "PatientArchive.h"
+
+using namespace std;
+
+// Parses patients.csv on a background thread.
+// The worker only reads and parses; the GUI thread takes parsed rows in
+// small batches (see BackendInterface::poll) and inserts them into the
+// record store itself, so the store stays single-threaded. The worker stops
+// reading ahead once MAX_PENDING rows are waiting.
+class PatientLoader {
+private:
+    static const size_t MAX_PENDING = 64 * 1024;
+
+    thread worker;
+    mutex lock;
+    condition_variable space;
+    deque<PatientRecord> pending;
+    bool cancelled;
+    atomic<bool> finished;
+    atomic<int> skipped;
+    atomic<long long> bytesRead;
+    long long totalBytes;
+
+    void run(string filename);
+
+public:
+    PatientLoader();
+    ~PatientLoader();
+    PatientLoader(const PatientLoader&) = delete;
+    PatientLoader& operator=(const PatientLoader&) = delete;
+
+    // Returns false (and counts as done) if the file cannot be opened
+    bool start(const string& filename);
+    // Moves up to maxRows parsed rows into out (cleared first)
+    size_t take(vector<PatientRecord>& out, size_t maxRows);
+
+    // True once the file is parsed and every row has been taken
+    bool done();
+    float progress() const;
+    // Malformed records left out so far
+    int skippedRows() const { return skipped; }
+
+    // Highest ID in the file, from a quick pass over the first column only,
+    // so new registrations can start above it before the load finishes
+    static int scanMaxID(const string& filename);
+    // One CSV record; false if it is malformed. Older files have no
+    // admission column.
+    static bool parseLine(const string& line, PatientRecord& out);
+    // Reads one record, which spans several lines when a quoted field
+    // holds newlines
+    static bool readRecord(istream& in, string& record);
+    // Writes a text field, quoted when it holds a comma, quote or newline
+    static void writeField(ostream& out, const char* field);
+};
+
+#endif
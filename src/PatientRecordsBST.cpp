@@ -1,11 +1,13 @@
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include "PatientRecordsBST.h"
-#include <sstream>
+#include "PatientLoader.h"
 
 
 PatientRecordsBST::PatientRecordsBST() {
     root = nullptr;
+    hotLimit = 0;
 }
 
 PatientRecordsBST::~PatientRecordsBST() {
@@ -16,88 +18,394 @@ bool PatientRecordsBST::saveToFile(const string& filename) {
     if (!file.is_open()) return false;
 
     // CSV Header
-    file << "PatientID,Name,Age,Symptoms,Priority\n";
+    file << "PatientID,Name,Age,Symptoms,Priority,AdmissionTime\n";
 
     vector<PatientData> patients = getAllPatients();
 
     for (const auto& p : patients) {
-        file << p.patientID << ","
-             << p.name << ","
-             << p.age << ","
-             << p.symptoms << ","
-             << p.priorityLevel << "\n";  // Added \n here - this was missing!
+        file << p.patientID << ",";
+        PatientLoader::writeField(file, text(p.nameID));
+        file << "," << p.age << ",";
+        PatientLoader::writeField(file, text(p.symptomsID));
+        file << "," << p.priorityLevel << ","
+             << p.admissionTime << "\n";
     }
 
     file.close();
-    return true;
+    return !file.fail();
 }
-bool PatientRecordsBST::loadFromFile(const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) return false;
 
-    string line;
-    getline(file, line); // Skip header
+void PatientRecordsBST::destroyTree(PatientNode* node) {
+    if (!node) return;
+    destroyTree(node->left);
+    destroyTree(node->right);
+    delete node;
+}
 
-    while (getline(file, line)) {
-        stringstream ss(line);
-        string token;
+static int heightOf(const PatientNode* node) {
+    return node ? node->height : 0;
+}
 
-        PatientData p;
+static void updateHeight(PatientNode* node) {
+    node->height = 1 + max(heightOf(node->left), heightOf(node->right));
+}
 
-        getline(ss, token, ','); p.patientID = stoi(token);
-        getline(ss, p.name, ',');
-        getline(ss, token, ','); p.age = stoi(token);
-        getline(ss, p.symptoms, ',');
-        getline(ss, token, ','); p.priorityLevel = stoi(token);
+static PatientNode* rotateRight(PatientNode* node) {
+    PatientNode* top = node->left;
+    node->left = top->right;
+    top->right = node;
+    updateHeight(node);
+    updateHeight(top);
+    return top;
+}
 
-        insertPatient(p);
-    }
+static PatientNode* rotateLeft(PatientNode* node) {
+    PatientNode* top = node->right;
+    node->right = top->left;
+    top->left = node;
+    updateHeight(node);
+    updateHeight(top);
+    return top;
+}
 
-    file.close();
-    return true;
+// Restores the AVL invariant at node once its subtrees are balanced and
+// differ in height by at most 2
+static PatientNode* rebalance(PatientNode* node) {
+    updateHeight(node);
+    int balance = heightOf(node->left) - heightOf(node->right);
+    if (balance > 1) {
+        if (heightOf(node->left->left) < heightOf(node->left->right))
+            node->left = rotateLeft(node->left);
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        if (heightOf(node->right->right) < heightOf(node->right->left))
+            node->right = rotateRight(node->right);
+        return rotateLeft(node);
+    }
+    return node;
 }
 
+PatientNode* PatientRecordsBST::insertHelper(PatientNode* node, int id, int handle, bool& inserted) {
+    if (!node) {
+        inserted = true;
+        return new PatientNode(id, handle);
+    }
 
-void PatientRecordsBST::destroyTree(PatientNode* node) {
-    if (!node) return;
-    destroyTree(node->left);
-    destroyTree(node->right);
-    delete node;
+    if (id < node->patientID)
+        node->left = insertHelper(node->left, id, handle, inserted);
+    else if (id > node->patientID)
+        node->right = insertHelper(node->right, id, handle, inserted);
+    else
+        return node;
+
+    return rebalance(node);
 }
 
-PatientNode* PatientRecordsBST::insertHelper(PatientNode* node, PatientData data) {
-    if (!node) return new PatientNode(data);
+// Puts the record in a slot and updates the secondary indexes; the tree
+// node is the caller's job
+int PatientRecordsBST::storeRecord(const PatientData& data) {
+    int handle;
+    if (freeHandles.empty()) {
+        handle = records.size();
+        records.push_back(data);
+    } else {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        records[handle] = data;
+    }
+    byID.insert(data.patientID, handle);
+    admissions.add(data.admissionTime, handle);
+    return handle;
+}
 
-    if (data.patientID < node->data.patientID)
-        node->left = insertHelper(node->left, data);
-    else if (data.patientID > node->data.patientID)
-        node->right = insertHelper(node->right, data);
+int PatientRecordsBST::insertPatient(const PatientData& data) {
+    // An archived ID can come back from a patients.csv saved before its
+    // eviction; keeping it would archive it a second time
+    if (cold.contains(data.patientID)) return -1;
+    bool inserted = false;
+    int handle = freeHandles.empty() ? (int)records.size() : freeHandles.back();
+    root = insertHelper(root, data.patientID, handle, inserted);
+    if (!inserted) return -1;
+    return storeRecord(data);
+}
 
+PatientNode* PatientRecordsBST::buildBalanced(const vector<PatientData>& block, const vector<int>& handles,
+                                              int lo, int hi) {
+    if (lo > hi) return nullptr;
+    int mid = lo + (hi - lo) / 2;
+    PatientNode* node = new PatientNode(block[mid].patientID, handles[mid]);
+    node->left = buildBalanced(block, handles, lo, mid - 1);
+    node->right = buildBalanced(block, handles, mid + 1, hi);
+    updateHeight(node);
     return node;
 }
 
-bool PatientRecordsBST::insertPatient(PatientData data) {
-    root = insertHelper(root, data);
-    return true;
+// Every key in left < pivot < every key in right. Walks down the taller
+// tree's inner spine to a subtree of matching height, so the cost is the
+// height difference.
+PatientNode* PatientRecordsBST::join(PatientNode* left, PatientNode* pivot, PatientNode* right) {
+    if (heightOf(left) > heightOf(right) + 1) {
+        left->right = join(left->right, pivot, right);
+        return rebalance(left);
+    }
+    if (heightOf(right) > heightOf(left) + 1) {
+        right->left = join(left, pivot, right->left);
+        return rebalance(right);
+    }
+    pivot->left = left;
+    pivot->right = right;
+    updateHeight(pivot);
+    return pivot;
+}
+
+vector<int> PatientRecordsBST::insertBlock(const vector<PatientData>& block) {
+    vector<int> handles;
+    handles.reserve(block.size());
+    if (block.empty()) return handles;
+
+    PatientNode* last = root;
+    while (last && last->right) last = last->right;
+    bool fresh = (!last || block.front().patientID > last->patientID) &&
+                 block.front().patientID > cold.maxPatientID();
+    for (size_t i = 1; fresh && i < block.size(); i++)
+        fresh = block[i].patientID > block[i - 1].patientID;
+
+    if (!fresh) {
+        for (const PatientData& pd : block) handles.push_back(insertPatient(pd));
+        return handles;
+    }
+
+    byID.reserve(byID.size() + block.size());
+    for (const PatientData& pd : block) handles.push_back(storeRecord(pd));
+    PatientNode* pivot = new PatientNode(block[0].patientID, handles[0]);
+    root = join(root, pivot, buildBalanced(block, handles, 1, (int)block.size() - 1));
+    return handles;
+}
+
+void PatientRecordsBST::freeRecord(int handle) {
+    int id = records[handle].patientID;
+    root = removeHelper(root, id);
+    byID.erase(id);
+    records[handle] = PatientData();
+    records[handle].patientID = -1;
+    freeHandles.push_back(handle);
 }
 
-PatientNode* PatientRecordsBST::searchHelper(PatientNode* node, int id) {
-    if (!node || node->data.patientID == id) return node;
-    if (id < node->data.patientID)
-        return searchHelper(node->left, id);
-    return searchHelper(node->right, id);
+int PatientRecordsBST::updatePatient(int id, const PatientData& fields) {
+    PatientData* pd = searchPatient(id);
+    if (!pd) return -1;
+    int handle = pd - records.data();
+    if (fields.admissionTime != pd->admissionTime) {
+        admissions.remove(pd->admissionTime, handle);
+        admissions.add(fields.admissionTime, handle);
+    }
+    *pd = fields;
+    pd->patientID = id;
+    return handle;
 }
 
-PatientData* PatientRecordsBST::searchPatient(int id) {
-    PatientNode* node = searchHelper(root, id);
+int PatientRecordsBST::deletePatient(int id) {
+    int handle = findHandle(id);
+    if (handle < 0) return -1;
+    admissions.remove(records[handle].admissionTime, handle);
+    freeRecord(handle);
+    return handle;
+}
+
+vector<int> PatientRecordsBST::updatePatients(const vector<PatientData>& changes) {
+    vector<int> handles;
+    handles.reserve(changes.size());
+    vector<char> moved;
+    for (const PatientData& change : changes) {
+        PatientData* pd = searchPatient(change.patientID);
+        if (!pd) {
+            handles.push_back(-1);
+            continue;
+        }
+        int handle = pd - records.data();
+        if (change.admissionTime != pd->admissionTime) {
+            if (moved.empty()) moved.assign(records.size(), 0);
+            moved[handle] = 1;
+        }
+        *pd = change;
+        handles.push_back(handle);
+    }
+
+    // Re-file the moved entries: one pass to drop them, one sorted merge
+    if (!moved.empty()) {
+        admissions.removeHandles(moved);
+        admissions.beginBulk();
+        for (size_t h = 0; h < moved.size(); h++) {
+            if (moved[h]) admissions.add(records[h].admissionTime, h);
+        }
+        admissions.finishBulk();
+    }
+    return handles;
+}
+
+vector<int> PatientRecordsBST::deletePatients(const vector<int>& ids) {
+    vector<int> handles;
+    handles.reserve(ids.size());
+    vector<char> dead(records.size(), 0);
+    for (int id : ids) {
+        int handle = findHandle(id);
+        handles.push_back(handle);
+        if (handle < 0) continue;
+        freeRecord(handle);
+        dead[handle] = 1;
+    }
+    admissions.removeHandles(dead);
+    return handles;
+}
+
+// Height of the subtree if it is valid with keys in (lo, hi), else -1
+int PatientRecordsBST::checkSubtree(const PatientNode* node, long long lo, long long hi, int& count) const {
+    if (!node) return 0;
+    if (node->patientID <= lo || node->patientID >= hi) return -1;
+    if (node->handle < 0 || node->handle >= (int)records.size()) return -1;
+    if (records[node->handle].patientID != node->patientID) return -1;
+    if (byID.find(node->patientID) != node->handle) return -1;
+    count++;
+    int left = checkSubtree(node->left, lo, node->patientID, count);
+    int right = checkSubtree(node->right, node->patientID, hi, count);
+    if (left < 0 || right < 0 || left - right > 1 || right - left > 1) return -1;
+    int height = 1 + max(left, right);
+    return height == node->height ? height : -1;
+}
+
+bool PatientRecordsBST::isConsistent() const {
+    int count = 0;
+    return checkSubtree(root, -(1LL << 40), 1LL << 40, count) >= 0 && count == liveCount();
+}
+
+PatientNode* PatientRecordsBST::removeHelper(PatientNode* node, int id) {
     if (!node) return nullptr;
-    return &node->data;
+
+    if (id < node->patientID) {
+        node->left = removeHelper(node->left, id);
+    } else if (id > node->patientID) {
+        node->right = removeHelper(node->right, id);
+    } else if (!node->left || !node->right) {
+        PatientNode* child = node->left ? node->left : node->right;
+        delete node;
+        return child;
+    } else {
+        // Two children: take over the in-order successor's key and handle
+        PatientNode* succ = node->right;
+        while (succ->left) succ = succ->left;
+        node->patientID = succ->patientID;
+        node->handle = succ->handle;
+        node->right = removeHelper(node->right, succ->patientID);
+    }
+    return rebalance(node);
+}
+
+PatientRecord PatientRecordsBST::toRecord(const PatientData& pd) const {
+    PatientRecord r;
+    r.patientID = pd.patientID;
+    r.name = text(pd.nameID);
+    r.age = pd.age;
+    r.symptoms = text(pd.symptomsID);
+    r.priorityLevel = pd.priorityLevel;
+    r.admissionTime = pd.admissionTime;
+    return r;
+}
+
+vector<int> PatientRecordsBST::evictColdRecords() {
+    vector<int> evicted;
+    if (hotLimit == 0 || (size_t)liveCount() <= hotLimit || !cold.isOpen()) return evicted;
+
+    // Evict down to 90% of the limit so blocks are large and evictions rare
+    size_t target = hotLimit - hotLimit / 10;
+    // Waiting patients alone are over that (a large bulk intake): wait for a
+    // full block of discharges rather than evicting one per treatment
+    size_t waiting = (size_t)liveCount() - min(discharged.size(), (size_t)liveCount());
+    if (waiting > target && discharged.size() < hotLimit / 10) return evicted;
+    vector<PatientRecord> batch;
+    vector<pair<int, int> > taken;
+    while ((size_t)liveCount() - evicted.size() > target && !discharged.empty()) {
+        pair<int, int> d = discharged.front();
+        discharged.pop_front();
+        PatientData* pd = getRecord(d.first);
+        // Deleted since discharge, maybe with the slot reused
+        if (!pd || pd->patientID != d.second) continue;
+        evicted.push_back(d.first);
+        taken.push_back(d);
+        batch.push_back(toRecord(*pd));
+    }
+    if (batch.empty()) return evicted;
+
+    if (!cold.appendBlock(batch)) {
+        // Keep everything hot if the segment cannot be written
+        discharged.insert(discharged.begin(), taken.begin(), taken.end());
+        return vector<int>();
+    }
+
+    vector<char> dead(records.size(), 0);
+    for (int handle : evicted) {
+        freeRecord(handle);
+        dead[handle] = 1;
+    }
+    admissions.removeHandles(dead);
+
+    // Names are mostly unique, so reclaim pool space once most of it is dead
+    if (strings.size() > 4 * (size_t)liveCount() + 1024) compactStrings();
+    return evicted;
+}
+
+vector<int> PatientRecordsBST::alsoCold() {
+    // ID order keeps ColdStore::contains() on its cached row group
+    vector<int> ids;
+    for (const PatientData& pd : getAllPatients()) {
+        if (cold.contains(pd.patientID)) ids.push_back(pd.patientID);
+    }
+    return ids;
+}
+
+// Invalidates every text() pointer and every copied nameID/symptomsID;
+// callers must not hold them across evictColdRecords()
+void PatientRecordsBST::compactStrings() {
+    StringPool fresh;
+    for (PatientData& pd : records) {
+        if (pd.patientID < 0) continue;
+        pd.nameID = fresh.intern(strings.get(pd.nameID));
+        pd.symptomsID = fresh.intern(strings.get(pd.symptomsID));
+    }
+    strings.swap(fresh);
+}
+
+bool PatientRecordsBST::findPatient(int id, PatientRecord& out) {
+    PatientData* pd = searchPatient(id);
+    if (pd) {
+        out = toRecord(*pd);
+        return true;
+    }
+    return cold.find(id, out);
+}
+
+int PatientRecordsBST::maxPatientID() const {
+    int maxID = cold.maxPatientID();
+    PatientNode* node = root;
+    while (node && node->right) node = node->right;
+    if (node && node->patientID > maxID) maxID = node->patientID;
+    return maxID;
+}
+
+PatientData* PatientRecordsBST::getRecord(int handle) {
+    if (handle < 0 || handle >= (int)records.size()) return nullptr;
+    if (records[handle].patientID < 0) return nullptr; // freed slot
+    return &records[handle];
+}
+
+PatientData* PatientRecordsBST::searchPatient(int id) {
+    return getRecord(findHandle(id));
 }
 
 void PatientRecordsBST::inOrderHelper(PatientNode* node, vector<PatientData>& list) {
     if (!node) return;
     inOrderHelper(node->left, list);
-    list.push_back(node->data);
+    list.push_back(records[node->handle]);
     inOrderHelper(node->right, list);
 }
 
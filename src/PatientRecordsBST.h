@@ -3,52 +3,147 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include "StringPool.h"
+#include "AdmissionIndex.h"
+#include "PatientIDIndex.h"
+#include "ColdStore.h"
 
 using namespace std;
 
+// Name and symptoms are IDs into the record store's StringPool
 struct PatientData {
     int patientID;
-    string name;
+    unsigned int nameID;
     int age;
-    string symptoms;
+    unsigned int symptomsID;
     int priorityLevel; // 1=Critical, 2=Urgent, 3=Standard
-    string admissionTime;
+    long long admissionTime; // epoch seconds, 0 = unknown
 
     // Default constructor
-    PatientData() : patientID(0), age(0), priorityLevel(3) {}
+    PatientData() : patientID(0), nameID(0), age(0), symptomsID(0), priorityLevel(3), admissionTime(0) {}
 
     // Parameterized constructor
-    PatientData(int id, const string& n, int a, const string& s, int p, const string& time = "")
-        : patientID(id), name(n), age(a), symptoms(s), priorityLevel(p), admissionTime(time) {}
+    PatientData(int id, unsigned int n, int a, unsigned int s, int p, long long time = 0)
+        : patientID(id), nameID(n), age(a), symptomsID(s), priorityLevel(p), admissionTime(time) {}
 };
 
+// Tree nodes only hold the key and a handle; the record itself lives in the
+// records table so the emergency queue can refer to it by the same handle.
+// The tree is kept AVL balanced: IDs are handed out in increasing order and
+// patients.csv is saved sorted, which would otherwise degrade it to a list.
 struct PatientNode {
-    PatientData data;
+    int patientID;
+    int handle;
+    int height;   // leaf = 1
     PatientNode* left;
     PatientNode* right;
 
-    PatientNode(PatientData d) : data(d), left(nullptr), right(nullptr) {}
+    PatientNode(int id, int h) : patientID(id), handle(h), height(1), left(nullptr), right(nullptr) {}
 };
 
 class PatientRecordsBST {
 private:
     PatientNode* root;
+    vector<PatientData> records; // canonical record store, indexed by handle
+    StringPool strings;          // shared text for names and symptoms
+    AdmissionIndex admissions;   // admission time -> handle
+    PatientIDIndex byID;         // patient ID -> handle, for point lookups
+
+    // Hot/cold tiering: discharged records are moved to the cold segment,
+    // oldest discharge first, once the hot set exceeds hotLimit.
+    vector<int> freeHandles;
+    deque<pair<int, int> > discharged; // (handle, patientID): skipped if the slot was reused
+    ColdStore cold;
+    size_t hotLimit;             // 0 = unlimited
 
-    PatientNode* insertHelper(PatientNode* node, PatientData data);
-    PatientNode* searchHelper(PatientNode* node, int id);
+    PatientNode* insertHelper(PatientNode* node, int id, int handle, bool& inserted);
+    PatientNode* buildBalanced(const vector<PatientData>& block, const vector<int>& handles, int lo, int hi);
+    PatientNode* join(PatientNode* left, PatientNode* pivot, PatientNode* right);
+    int storeRecord(const PatientData& data);
+    void freeRecord(int handle);
+    PatientNode* removeHelper(PatientNode* node, int id);
+    void compactStrings();
+    PatientRecord toRecord(const PatientData& pd) const;
     void inOrderHelper(PatientNode* node, vector<PatientData>& list);
+    int checkSubtree(const PatientNode* node, long long lo, long long hi, int& count) const;
     void destroyTree(PatientNode* node);
 
 public:
     PatientRecordsBST();
     ~PatientRecordsBST();
 
-    bool insertPatient(PatientData data);
+    // Returns the new record's handle, or -1 if the ID already exists,
+    // in memory or in the cold segment
+    int insertPatient(const PatientData& data);
+    // Inserts a batch sorted by ascending ID and returns the handles (-1 for
+    // a duplicate). A batch above every ID in the tree and on disk, such as
+    // a freshly reserved ID block, is built as a balanced subtree and joined
+    // onto the right of the tree in O(k + log n); any other batch is
+    // inserted record by record.
+    vector<int> insertBlock(const vector<PatientData>& block);
+
+    // Corrects a record in place; the ID is the key and stays. The admission
+    // index is told if the admission time changed. Returns the handle, or -1
+    // if the ID is not in memory (archived records are read-only).
+    int updatePatient(int id, const PatientData& fields);
+    // Removes a record in O(log n) with rebalancing and frees its handle.
+    // Returns the freed handle, or -1.
+    int deletePatient(int id);
+    // Batches: the admission index is fixed up in one pass per batch
+    // instead of one shift per record
+    vector<int> updatePatients(const vector<PatientData>& changes);
+    vector<int> deletePatients(const vector<int>& ids);
+    // Wrap a batch of inserts of older records so the admission index
+    // sorts them once instead of shifting entries for each
+    void beginBulkLoad() { admissions.beginBulk(); }
+    void finishBulkLoad() { admissions.finishBulk(); }
     // File Operations
     bool saveToFile(const string& filename);
-    bool loadFromFile(const string& filename);
 
+    // Point lookups go through the hash index, O(1)
     PatientData* searchPatient(int id);
+    int findHandle(int id) const { return byID.find(id); }
+    PatientData* getRecord(int handle);
+    // Number of handle slots (live or free); valid handles are below this
+    int recordCount() const { return records.size(); }
+    int liveCount() const { return records.size() - freeHandles.size(); }
+    int treeHeight() const { return root ? root->height : 0; }
+    // Walks the whole tree, O(n), for tests: key order, stored heights, AVL
+    // balance, and every node's handle pointing at its own live record
+    bool isConsistent() const;
+    int maxPatientID() const;
+
+    // Hot lookup first, then the cold segment
+    bool findPatient(int id, PatientRecord& out);
+
+    // Tiering
+    bool openColdStore(const string& filename) { return cold.open(filename); }
+    void setHotLimit(size_t limit) { hotLimit = limit; }
+    void markDischarged(int handle) {
+        if (getRecord(handle)) discharged.push_back(make_pair(handle, records[handle].patientID));
+    }
+    // Moves discharged records to disk until the hot set fits, returning
+    // the handles that were freed
+    vector<int> evictColdRecords();
+    // IDs held both in memory and in the cold segment, in ID order. Only a
+    // promoted standby has them: copies of rows the old primary archived.
+    vector<int> alsoCold();
+    size_t coldCount() const { return cold.size(); }
+    const RetiredSummary& coldSummary() const { return cold.getSummary(); }
+    const string& coldFilename() const { return cold.getFilename(); }
+
+    // Admission time queries, O(log n + k)
+    vector<int> admittedBetween(long long from, long long to) const { return admissions.between(from, to); }
+    vector<int> arrivalsPerHour(long long now, int hours) const { return admissions.perHour(now, hours); }
+
+    // String pool access. The pool is compacted during evictColdRecords(),
+    // which renumbers IDs and frees the old text: pointers from text() and
+    // IDs in PatientData copies are only good until the next eviction.
+    unsigned int intern(const string& s) { return strings.intern(s); }
+    unsigned int intern(const char* s) { return strings.intern(s); }
+    const char* text(unsigned int id) const { return strings.get(id); }
+    const StringPool& getStringPool() const { return strings; }
     vector<PatientData> getAllPatients();
 };
 
@@ -0,0 +1,195 @@
+#include "QueueCheckpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char CHECKPOINT_MAGIC[4] = { 'H', 'Q', 'C', 'K' };
+static const unsigned int CHECKPOINT_VERSION = 2;
+
+void CheckpointImage::begin(const AgingPolicy& aging, unsigned long long nextSeq) {
+    memset(static_cast<void*>(&header), 0, sizeof(header)); // padding included
+    memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.version = CHECKPOINT_VERSION;
+    header.savedAt = (long long)time(nullptr);
+    header.nextSeq = nextSeq;
+    header.aging = aging;
+    // Room for the header, filled in by take()
+    data.assign(sizeof(CheckpointHeader), '\0');
+}
+
+static unsigned short textBytes(const char* s) {
+    size_t n = strlen(s);
+    if (n > 0xFFFE) n = 0xFFFE;
+    return (unsigned short)(n + 1);
+}
+
+void CheckpointImage::add(int dept, const QueueEntry& e, int patientID, int age, long long admissionTime,
+                          const char* name, const char* symptoms) {
+    CheckpointEntry ce;
+    memset(&ce, 0, sizeof(ce));
+    ce.key = e.key;
+    ce.seq = e.seq;
+    ce.admissionTime = admissionTime;
+    ce.patientID = patientID;
+    ce.priority = e.priority;
+    ce.age = age;
+    ce.nameBytes = textBytes(name);
+    ce.symptomsBytes = textBytes(symptoms);
+
+    data.append((const char*)&ce, sizeof(ce));
+    data.append(name, ce.nameBytes - 1);
+    data.push_back('\0');
+    data.append(symptoms, ce.symptomsBytes - 1);
+    data.push_back('\0');
+    header.counts[dept]++;
+}
+
+string CheckpointImage::take() {
+    header.payloadBytes = data.size() - sizeof(CheckpointHeader);
+    memcpy(&data[0], &header, sizeof(header));
+    string out;
+    out.swap(data);
+    return out;
+}
+
+bool CheckpointReader::open(const string& filename) {
+    data.clear();
+    pos = 0;
+    dept = 0;
+    left = 0;
+
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = size >= (long)sizeof(CheckpointHeader);
+    if (ok) {
+        data.resize(size);
+        ok = fread(data.data(), 1, size, f) == (size_t)size;
+    }
+    fclose(f);
+    if (!ok) return false;
+
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, 4) != 0 || header.version != CHECKPOINT_VERSION ||
+        header.payloadBytes != data.size() - sizeof(CheckpointHeader)) {
+        return false;
+    }
+
+    // Walk the entries once so next() never runs off the buffer
+    size_t at = sizeof(CheckpointHeader);
+    for (unsigned int i = 0; i < total(); i++) {
+        if (at + sizeof(CheckpointEntry) > data.size()) return false;
+        CheckpointEntry ce;
+        memcpy(&ce, &data[at], sizeof(ce));
+        at += sizeof(ce);
+        if (ce.nameBytes == 0 || ce.symptomsBytes == 0 ||
+            at + ce.nameBytes + ce.symptomsBytes > data.size() ||
+            data[at + ce.nameBytes - 1] != '\0' || data[at + ce.nameBytes + ce.symptomsBytes - 1] != '\0') {
+            return false;
+        }
+        at += ce.nameBytes + ce.symptomsBytes;
+    }
+    if (at != data.size()) return false;
+
+    pos = sizeof(CheckpointHeader);
+    left = header.counts[0];
+    return true;
+}
+
+unsigned int CheckpointReader::total() const {
+    unsigned int n = 0;
+    for (int d = 0; d < DEPARTMENTS; d++) n += header.counts[d];
+    return n;
+}
+
+bool CheckpointReader::next(int& department, CheckpointEntry& e, const char*& name, const char*& symptoms) {
+    if (data.empty()) return false;
+    while (left == 0) {
+        if (++dept >= DEPARTMENTS) return false;
+        left = header.counts[dept];
+    }
+    left--;
+
+    memcpy(&e, &data[pos], sizeof(e));
+    pos += sizeof(e);
+    name = &data[pos];
+    symptoms = &data[pos + e.nameBytes];
+    pos += e.nameBytes + e.symptomsBytes;
+    department = dept;
+    return true;
+}
+
+CheckpointWriter::CheckpointWriter() : hasPending(false), stopping(false), lastOk(true) {}
+
+void CheckpointWriter::start(const string& filename) {
+    stop();
+    path = filename;
+    stopping = false;
+    worker = thread(&CheckpointWriter::run, this);
+}
+
+void CheckpointWriter::submit(string image) {
+    {
+        lock_guard<mutex> guard(lock);
+        pending.swap(image);
+        hasPending = true;
+    }
+    ready.notify_one();
+}
+
+void CheckpointWriter::stop() {
+    if (!worker.joinable()) return;
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    ready.notify_one();
+    worker.join();
+}
+
+bool CheckpointWriter::lastWriteOk() {
+    lock_guard<mutex> guard(lock);
+    return lastOk;
+}
+
+void CheckpointWriter::run() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        ready.wait(guard, [this] { return stopping || hasPending; });
+        if (hasPending) {
+            string image;
+            image.swap(pending);
+            hasPending = false;
+            guard.unlock();
+            bool ok = write(path, image);
+            guard.lock();
+            lastOk = ok;
+            continue;
+        }
+        if (stopping) break;
+    }
+}
+
+bool CheckpointWriter::write(const string& filename, const string& image) {
+    string tmp = filename + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    size_t done = 0;
+    while (done < image.size()) {
+        ssize_t n = ::write(fd, image.data() + done, image.size() - done);
+        if (n <= 0) break;
+        done += n;
+    }
+    bool ok = done == image.size() && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || rename(tmp.c_str(), filename.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
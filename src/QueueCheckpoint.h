@@ -0,0 +1,120 @@
+#ifndef QUEUE_CHECKPOINT_H
+#define QUEUE_CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "TreatmentDispatcher.h"
+
+using namespace std;
+
+// Checkpoint of the emergency queue (patients_queue.dat).
+//
+// The image holds each department's heap array in heap order. Each entry
+// also carries a copy of the waiting patient's record, because patients.csv
+// is only written on a clean exit. Handles differ between runs, so entries
+// are keyed by patient ID. Restoring a shard is one O(n) heap build over the
+// stored array.
+//
+// The GUI thread serializes the image into a buffer. A writer thread writes
+// the buffer to a temporary file and renames it over the previous
+// checkpoint, so a crash mid-write keeps the old one intact.
+//
+// File: CheckpointHeader, then the entries of department 0, 1, ... in heap
+// order. Each entry is a CheckpointEntry followed by the NUL-terminated name
+// and symptoms.
+
+const char* const QUEUE_CHECKPOINT = "patients_queue.dat";
+
+struct CheckpointHeader {
+    char magic[4];
+    unsigned int version;
+    long long savedAt;                  // epoch seconds
+    unsigned long long nextSeq;         // queue sequence to continue from
+    AgingPolicy aging;                  // the policy the keys were made with
+    unsigned int counts[DEPARTMENTS];
+    unsigned long long payloadBytes;
+};
+
+struct CheckpointEntry {
+    unsigned long long key;
+    unsigned long long seq;
+    long long admissionTime;
+    int patientID;
+    int priority;
+    int age;
+    unsigned short nameBytes;           // including the NUL
+    unsigned short symptomsBytes;
+};
+
+// Serializes a queue image. Add entries department by department, each in
+// heap order (TreatmentDispatcher::snapshot).
+class CheckpointImage {
+private:
+    string data;
+    CheckpointHeader header;
+
+public:
+    void begin(const AgingPolicy& aging, unsigned long long nextSeq);
+    void add(int dept, const QueueEntry& e, int patientID, int age, long long admissionTime,
+             const char* name, const char* symptoms);
+    // The finished file contents; the image is empty afterwards
+    string take();
+    size_t size() const { return data.size(); }
+};
+
+// Reads a whole checkpoint and validates it before handing out entries
+class CheckpointReader {
+private:
+    vector<char> data;
+    CheckpointHeader header;
+    size_t pos;
+    int dept;
+    unsigned int left;
+
+public:
+    CheckpointReader() : pos(0), dept(0), left(0) {}
+
+    // False if the file is missing, truncated or from another version
+    bool open(const string& filename);
+    const CheckpointHeader& getHeader() const { return header; }
+    unsigned int total() const;
+    // Next entry in file order. Text points into the reader's buffer.
+    bool next(int& department, CheckpointEntry& e, const char*& name, const char*& symptoms);
+};
+
+// Writes images off the GUI thread. A newer image replaces one still
+// waiting, so a slow disk costs checkpoint frequency, not frame time.
+class CheckpointWriter {
+private:
+    string path;
+    thread worker;
+    mutex lock;
+    condition_variable ready;
+    string pending;
+    bool hasPending;
+    bool stopping;
+    bool lastOk;
+
+    void run();
+
+public:
+    CheckpointWriter();
+    ~CheckpointWriter() { stop(); }
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void start(const string& filename);
+    void submit(string image);
+    // Writes the image still waiting, if any, then joins the thread
+    void stop();
+    bool isRunning() const { return worker.joinable(); }
+    bool lastWriteOk();
+
+    // Temporary file + fsync + rename
+    static bool write(const string& filename, const string& image);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "QueueReplica.h"
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "seqlock needs a lock-free atomic in shared memory");
+
+static const unsigned int REPLICA_MAGIC = 0x51524550; // "PERQ"
+static const unsigned int REPLICA_VERSION = 1;
+
+struct ReplicaSegment {
+    unsigned int magic;
+    unsigned int version;
+    atomic<unsigned int> seq; // odd while a write is in progress
+    ReplicaSnapshot data;
+};
+
+bool ReplicaPublisher::open(const char* name) {
+    close();
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+
+    void* mem = MAP_FAILED;
+    if (ftruncate(fd, sizeof(ReplicaSegment)) == 0)
+        mem = mmap(nullptr, sizeof(ReplicaSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(name);
+        return false;
+    }
+
+    // The new segment is zero-filled; magic goes last so readers that open
+    // it early see it as not ready yet
+    segment = static_cast<ReplicaSegment*>(mem);
+    this->name = name;
+    pid = getpid();
+    segment->version = REPLICA_VERSION;
+    segment->seq.store(0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    segment->magic = REPLICA_MAGIC;
+    return true;
+}
+
+void ReplicaPublisher::close() {
+    if (!segment) return;
+    munmap(segment, sizeof(ReplicaSegment));
+    segment = nullptr;
+    // Readers keep their mapping; they notice the stopped heartbeat
+    shm_unlink(name.c_str());
+}
+
+void ReplicaPublisher::publish(const ReplicaSnapshot& snapshot) {
+    if (!segment) return;
+    unsigned int seq = segment->seq.load(memory_order_relaxed);
+    segment->seq.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&segment->data, &snapshot, sizeof(ReplicaSnapshot));
+    segment->data.writerPid = pid;
+    segment->seq.store(seq + 2, memory_order_release);
+}
+
+bool ReplicaReader::open(const char* name) {
+    close();
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(ReplicaSegment))
+        mem = mmap(nullptr, sizeof(ReplicaSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    const ReplicaSegment* seg = static_cast<const ReplicaSegment*>(mem);
+    if (seg->magic != REPLICA_MAGIC || seg->version != REPLICA_VERSION) {
+        munmap(mem, sizeof(ReplicaSegment));
+        return false;
+    }
+    segment = seg;
+    return true;
+}
+
+void ReplicaReader::close() {
+    if (!segment) return;
+    munmap(const_cast<ReplicaSegment*>(segment), sizeof(ReplicaSegment));
+    segment = nullptr;
+}
+
+bool ReplicaReader::read(ReplicaSnapshot& out) const {
+    if (!segment) return false;
+    // Copy aside so a torn copy never reaches out; the caller keeps
+    // showing its last good snapshot when every retry races a write
+    ReplicaSnapshot copy;
+    for (int attempt = 0; attempt < 64; attempt++) {
+        unsigned int before = segment->seq.load(memory_order_acquire);
+        if (before & 1) continue;
+        memcpy(&copy, &segment->data, sizeof(ReplicaSnapshot));
+        atomic_thread_fence(memory_order_acquire);
+        if (segment->seq.load(memory_order_relaxed) != before) continue;
+        if (before == 0) return false; // nothing published yet
+        out = copy;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,89 @@
+#ifndef QUEUE_REPLICA_H
+#define QUEUE_REPLICA_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "TreatmentDispatcher.h"
+
+using namespace std;
+
+// Read replica of the emergency queue for status boards.
+// The backend publishes a snapshot into a POSIX shared-memory segment under
+// a seqlock: the writer bumps the sequence to odd, copies the snapshot and
+// bumps it back to even, so it never waits for readers. Viewers map the
+// segment read-only and retry a copy that raced with a write, so a board
+// refresh is a memcpy and no syscalls.
+
+const char* const REPLICA_SHM_NAME = "/hospital_queue";
+const int REPLICA_MAX_ENTRIES = 32;
+
+// Everything in the snapshot is plain data: it is copied byte for byte
+struct ReplicaEntry {
+    int id;
+    int age;
+    int priority;
+    int department;
+    long long admissionTime;
+    char name[48];
+    char symptoms[64];
+};
+
+struct ReplicaSnapshot {
+    long long publishedAt;          // epoch seconds, also a heartbeat
+    int writerPid;
+    int queued;
+    int byPriority[4];              // indexed by priority, [0] unused
+    int byDepartment[DEPARTMENTS];
+    int treated;
+    int archived;
+    int totalRecords;
+    double serviceSeconds;          // projected wait per queue position
+    int entryCount;
+    ReplicaEntry entries[REPLICA_MAX_ENTRIES]; // treatment order
+};
+
+struct ReplicaSegment; // layout is private to QueueReplica.cpp
+
+class ReplicaPublisher {
+private:
+    ReplicaSegment* segment;
+    string name;
+    int pid;
+
+public:
+    ReplicaPublisher() : segment(nullptr), pid(0) {}
+    ~ReplicaPublisher() { close(); }
+    ReplicaPublisher(const ReplicaPublisher&) = delete;
+    ReplicaPublisher& operator=(const ReplicaPublisher&) = delete;
+
+    // Replaces any segment left behind by an earlier writer
+    bool open(const char* name = REPLICA_SHM_NAME);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+
+    // Never blocks; writerPid is filled in here
+    void publish(const ReplicaSnapshot& snapshot);
+};
+
+class ReplicaReader {
+private:
+    const ReplicaSegment* segment;
+
+public:
+    ReplicaReader() : segment(nullptr) {}
+    ~ReplicaReader() { close(); }
+    ReplicaReader(const ReplicaReader&) = delete;
+    ReplicaReader& operator=(const ReplicaReader&) = delete;
+
+    // Fails until a writer has created the segment
+    bool open(const char* name = REPLICA_SHM_NAME);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+
+    // Consistent copy of the latest snapshot; false, leaving out untouched,
+    // if the writer kept changing it (or died mid-write) for every retry
+    bool read(ReplicaSnapshot& out) const;
+};
+
+#endif
@@ -0,0 +1,577 @@
+#include "ReplicationLog.h"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static const unsigned int MAX_BATCH_ENTRIES = 256;
+static const size_t MAX_BATCH_BYTES = 64 * 1024;
+static const unsigned int MAX_FRAME_BYTES = 16 * 1024 * 1024;
+
+// ---- Encoding ----
+
+template <typename T>
+static void putValue(string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool getValue(const char*& p, const char* end, T& value) {
+    if (end - p < (ptrdiff_t)sizeof(T)) return false;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+static void putText(string& out, const string& s) {
+    putValue<unsigned int>(out, s.size());
+    out.append(s);
+}
+
+static bool getText(const char*& p, const char* end, string& s) {
+    unsigned int len;
+    if (!getValue(p, end, len) || end - p < (ptrdiff_t)len) return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+}
+
+static void encodeEntry(string& out, const LogEntry& e) {
+    putValue(out, e.lsn);
+    putValue(out, e.op);
+    putValue(out, e.patientID);
+    putValue(out, e.age);
+    putValue(out, e.priority);
+    putValue(out, e.department);
+    putValue(out, e.admissionTime);
+    putValue(out, e.seq);
+    putValue<int>(out, e.aging.enabled ? 1 : 0);
+    for (int i = 0; i < 4; i++) putValue(out, e.aging.offsetMinutes[i]);
+    putText(out, e.name);
+    putText(out, e.symptoms);
+}
+
+static bool decodeEntry(const char*& p, const char* end, LogEntry& e) {
+    int enabled = 0;
+    bool ok = getValue(p, end, e.lsn) && getValue(p, end, e.op) &&
+              getValue(p, end, e.patientID) && getValue(p, end, e.age) &&
+              getValue(p, end, e.priority) && getValue(p, end, e.department) &&
+              getValue(p, end, e.admissionTime) && getValue(p, end, e.seq) &&
+              getValue(p, end, enabled);
+    for (int i = 0; ok && i < 4; i++) ok = getValue(p, end, e.aging.offsetMinutes[i]);
+    e.aging.enabled = enabled != 0;
+    return ok && getText(p, end, e.name) && getText(p, end, e.symptoms);
+}
+
+// ---- Socket helpers ----
+
+static bool writeAll(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        // MSG_NOSIGNAL: a dead peer must not kill us with SIGPIPE
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= w;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t r = recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool socketAddress(const string& path, sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    strcpy(addr.sun_path, path.c_str());
+    return true;
+}
+
+// ---- Primary ----
+
+LogShipper::LogShipper()
+    : mode(ACK_ASYNC), session(0), baseLSN(0), ackedLSN(0), stopping(false), goodbye(false), connected(false),
+      snapshotWanted(false), snapshotReady(false), snapshotLSN(0) {
+    wakePipe[0] = wakePipe[1] = -1;
+}
+
+void LogShipper::start(const string& socketPath, AckMode ackMode) {
+    stop(false);
+    path = socketPath;
+    mode = ackMode;
+    // Distinguishes this run's log from a restarted primary's
+    session = (unsigned long long)chrono::system_clock::now().time_since_epoch().count() ^
+              ((unsigned long long)getpid() << 48);
+    if (session == 0) session = 1;
+    stopping = false;
+    goodbye = false;
+    if (pipe(wakePipe) == 0) {
+        fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+    } else {
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+    sender = thread(&LogShipper::run, this);
+}
+
+void LogShipper::stop(bool sendGoodbye) {
+    if (!sender.joinable()) return;
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+        goodbye = sendGoodbye;
+    }
+    acked.notify_all();
+    sender.join();
+    for (int& fd : wakePipe) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+}
+
+unsigned long long LogShipper::append(LogEntry entry) {
+    lock_guard<mutex> guard(lock);
+    entry.lsn = baseLSN + log.size() + 1;
+    log.push_back(std::move(entry));
+    trim();
+    return entry.lsn;
+}
+
+unsigned long long LogShipper::appendBatch(vector<LogEntry>& entries) {
+    lock_guard<mutex> guard(lock);
+    for (LogEntry& entry : entries) {
+        entry.lsn = baseLSN + log.size() + 1;
+        log.push_back(std::move(entry));
+    }
+    entries.clear();
+    trim();
+    return baseLSN + log.size();
+}
+
+// Caller holds the lock
+void LogShipper::trim() {
+    // Applied on the standby, so never sent again
+    while (!log.empty() && baseLSN < ackedLSN) {
+        log.pop_front();
+        baseLSN++;
+    }
+    // Kept for a standby that is away; past this it resyncs instead
+    while (log.size() > LOG_RETAINED_ENTRIES) {
+        log.pop_front();
+        baseLSN++;
+    }
+}
+
+bool LogShipper::sync(int timeoutMillis) {
+    if (mode != ACK_SYNC) return true;
+    // A full pipe already has a wakeup pending
+    char wake = 1;
+    if (wakePipe[1] >= 0 && write(wakePipe[1], &wake, 1) < 0) {}
+    unique_lock<mutex> guard(lock);
+    unsigned long long target = baseLSN + log.size();
+    acked.wait_for(guard, chrono::milliseconds(timeoutMillis),
+                   [&] { return ackedLSN >= target || !connected; });
+    return ackedLSN >= target;
+}
+
+bool LogShipper::snapshotRequested() {
+    lock_guard<mutex> guard(lock);
+    return snapshotWanted && !snapshotReady;
+}
+
+void LogShipper::provideSnapshot(vector<LogEntry>& entries) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (snapshotWanted && !snapshotReady) {
+            // Everything appended so far is in the state
+            snapshotLSN = baseLSN + log.size();
+            for (LogEntry& e : entries) e.lsn = snapshotLSN;
+            snapshot.swap(entries);
+            snapshotReady = true;
+        }
+    }
+    entries.clear();
+    acked.notify_all();
+}
+
+unsigned long long LogShipper::lastLSN() {
+    lock_guard<mutex> guard(lock);
+    return baseLSN + log.size();
+}
+
+size_t LogShipper::retainedEntries() {
+    lock_guard<mutex> guard(lock);
+    return log.size();
+}
+
+unsigned long long LogShipper::lastAcked() {
+    lock_guard<mutex> guard(lock);
+    return ackedLSN;
+}
+
+void LogShipper::run() {
+    sockaddr_un addr;
+    if (!socketAddress(path, addr)) return;
+
+    while (true) {
+        {
+            lock_guard<mutex> guard(lock);
+            if (stopping) return;
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+            connected = true;
+            serve(fd);
+            connected = false;
+            acked.notify_all();
+        }
+        if (fd >= 0) ::close(fd);
+
+        // No standby (yet): retry once a second
+        unique_lock<mutex> guard(lock);
+        acked.wait_for(guard, chrono::seconds(1), [this] { return stopping; });
+    }
+}
+
+// The entries after what the standby has are gone; it must start over
+bool LogShipper::sendResync(int fd) {
+    unsigned int frame[2] = { 0, RESYNC_FRAME };
+    writeAll(fd, frame, sizeof(frame));
+    return true;
+}
+
+bool LogShipper::serve(int fd) {
+    unsigned long long have;
+    if (!writeAll(fd, &session, sizeof(session))) return false;
+    // The standby closes instead of answering if it follows another session
+    if (!readAll(fd, &have, sizeof(have))) return false;
+
+    // A standby with nothing gets the state as of some LSN, then the log
+    // from there
+    unsigned long long start = have;
+    vector<LogEntry> state;
+    bool behind = false;
+    {
+        unique_lock<mutex> guard(lock);
+        if (have > baseLSN + log.size()) return false;
+        behind = have != 0 && have < baseLSN;
+        if (have == 0) {
+            snapshotWanted = true;
+            snapshotReady = false;
+            acked.wait(guard, [this] { return snapshotReady || stopping; });
+            snapshotWanted = false;
+            if (!snapshotReady) return true;
+            state.swap(snapshot);
+            start = snapshotLSN;
+        }
+        if (!behind && have > ackedLSN) ackedLSN = have;
+    }
+    acked.notify_all();
+    if (!writeAll(fd, &start, sizeof(start))) return false;
+    if (behind) return sendResync(fd);
+
+    string frame;
+    for (size_t i = 0; i < state.size(); ) {
+        unsigned int count = 0;
+        frame.assign(2 * sizeof(unsigned int), '\0');
+        while (i < state.size() && count < MAX_BATCH_ENTRIES && frame.size() < MAX_BATCH_BYTES) {
+            encodeEntry(frame, state[i++]);
+            count++;
+        }
+        unsigned int header[2] = { (unsigned int)(frame.size() - sizeof(header)), count | SNAPSHOT_FRAME };
+        memcpy(&frame[0], header, sizeof(header));
+        if (!writeAll(fd, frame.data(), frame.size())) return false;
+    }
+    if (have == 0) {
+        unsigned int end[2] = { 0, SNAPSHOT_END };
+        if (!writeAll(fd, end, sizeof(end))) return false;
+    }
+    vector<LogEntry>().swap(state);
+
+    unsigned long long next = start + 1;
+    char ackBuf[sizeof(unsigned long long)];
+    size_t ackFill = 0;
+    while (true) {
+        // Send whatever is new without waiting for acks (pipelining)
+        unsigned int count = 0;
+        bool finished = false;
+        frame.assign(2 * sizeof(unsigned int), '\0');
+        {
+            lock_guard<mutex> guard(lock);
+            // Capped away while this standby lagged
+            if (next <= baseLSN) behind = true;
+            while (!behind && next <= baseLSN + log.size() && count < MAX_BATCH_ENTRIES &&
+                   frame.size() < MAX_BATCH_BYTES) {
+                encodeEntry(frame, log[next - baseLSN - 1]);
+                next++;
+                count++;
+            }
+            if (count == 0 && stopping) {
+                if (!goodbye) return true;
+                finished = true;
+            }
+        }
+        if (behind) return sendResync(fd);
+        if (count > 0 || finished) {
+            unsigned int header[2] = { (unsigned int)(frame.size() - sizeof(header)), count };
+            memcpy(&frame[0], header, sizeof(header));
+            if (!writeAll(fd, frame.data(), frame.size())) return false;
+            if (finished) return true;
+        }
+
+        // Collect acks, also between frames so trimming keeps up under load.
+        // Idle, new appends wait up to 2 ms and go out together, unless
+        // sync() is waiting for them.
+        pollfd p[2] = { { fd, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+        int r = poll(p, 2, count > 0 ? 0 : 2);
+        if (r < 0 && errno != EINTR) return false;
+        if (r > 0 && (p[1].revents & POLLIN)) {
+            char drain[64];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (r <= 0 || !(p[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        ssize_t n = recv(fd, ackBuf + ackFill, sizeof(ackBuf) - ackFill, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        ackFill += n;
+        if (ackFill == sizeof(ackBuf)) {
+            unsigned long long lsn;
+            memcpy(&lsn, ackBuf, sizeof(lsn));
+            ackFill = 0;
+            {
+                lock_guard<mutex> guard(lock);
+                if (lsn > ackedLSN) ackedLSN = lsn;
+                trim();
+            }
+            acked.notify_all();
+        }
+    }
+}
+
+// ---- Standby ----
+
+LogReceiver::LogReceiver()
+    : listenFd(-1), connFd(-1), ackWanted(0), ackLoaded(0), ackSent(0), stopping(false), session(0),
+      receivedLSN(0), appliedLSN(0), connected(false),
+      synced(false), resyncNeeded(false), primaryLost(false), primaryClosed(false), sessionMismatch(false) {}
+
+bool LogReceiver::start(const string& socketPath) {
+    stop();
+    sockaddr_un addr;
+    if (!socketAddress(socketPath, addr)) return false;
+
+    // A socket file left by a crashed standby would make bind fail
+    unlink(socketPath.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 1) != 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    path = socketPath;
+    stopping = false;
+    worker = thread(&LogReceiver::run, this);
+    return true;
+}
+
+void LogReceiver::stop() {
+    if (listenFd < 0) return;
+    stopping = true;
+    {
+        // Unblocks a reader waiting inside a frame, and the accept loop
+        lock_guard<mutex> guard(connLock);
+        if (connFd >= 0) shutdown(connFd, SHUT_RDWR);
+        shutdown(listenFd, SHUT_RDWR);
+    }
+    if (worker.joinable()) worker.join();
+    ::close(listenFd);
+    listenFd = -1;
+    unlink(path.c_str());
+}
+
+void LogReceiver::run() {
+    while (!stopping) {
+        pollfd p = { listenFd, POLLIN, 0 };
+        if (poll(&p, 1, 100) <= 0) continue;
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        {
+            // Registered before the handshake, which waits while the
+            // primary builds a snapshot, so stop() can interrupt it
+            lock_guard<mutex> guard(connLock);
+            if (stopping) {
+                ::close(fd);
+                break;
+            }
+            connFd = fd;
+            ackWanted = ackLoaded = 0;
+            ackSent = 0;
+        }
+        follow(fd);
+        {
+            lock_guard<mutex> guard(connLock);
+            connFd = -1;
+        }
+        ::close(fd);
+    }
+}
+
+void LogReceiver::follow(int fd) {
+    if (resyncNeeded) return;
+    unsigned long long primarySession;
+    if (!readAll(fd, &primarySession, sizeof(primarySession))) return;
+    if (synced && primarySession != session) {
+        sessionMismatch = true;
+        return;
+    }
+    session = primarySession;
+    sessionMismatch = false;
+    primaryClosed = false;
+
+    // Resume after the last entry received, applied or not
+    unsigned long long received = 0;
+    if (synced) {
+        lock_guard<mutex> guard(lock);
+        received = receivedLSN;
+    }
+    unsigned long long start;
+    if (!writeAll(fd, &received, sizeof(received)) || !readAll(fd, &start, sizeof(start))) return;
+    connected = true;
+
+    vector<char> body;
+    bool clean = false;
+    bool partial = false; // some of a snapshot arrived, but not its end
+    while (!stopping) {
+        bool ackPending;
+        {
+            lock_guard<mutex> guard(connLock);
+            ackPending = flushAck();
+        }
+        pollfd p = { fd, (short)(POLLIN | (ackPending ? POLLOUT : 0)), 0 };
+        int r = poll(&p, 1, 100);
+        if (r < 0 && errno != EINTR) break;
+        if (r <= 0 || !(p.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        unsigned int header[2];
+        if (!readAll(fd, header, sizeof(header)) || header[0] > MAX_FRAME_BYTES) break;
+        if (header[1] == 0) {
+            clean = true;
+            break;
+        }
+        if (header[1] == RESYNC_FRAME) {
+            resyncNeeded = true;
+            break;
+        }
+        if (header[1] == SNAPSHOT_END) {
+            {
+                lock_guard<mutex> guard(lock);
+                receivedLSN = start;
+            }
+            synced = true;
+            partial = false;
+            acknowledge(start);
+            continue;
+        }
+        bool inSnapshot = (header[1] & SNAPSHOT_FRAME) != 0;
+        body.resize(header[0]);
+        if (!readAll(fd, body.data(), body.size())) break;
+
+        const char* q = body.data();
+        const char* end = q + body.size();
+        vector<LogEntry> batch(header[1] & ~SNAPSHOT_FRAME);
+        bool ok = true;
+        for (LogEntry& e : batch) ok = ok && decodeEntry(q, end, e);
+        if (!ok) break;
+
+        unsigned long long held;
+        {
+            lock_guard<mutex> guard(lock);
+            partial = partial || inSnapshot;
+            for (LogEntry& e : batch) {
+                // Snapshot entries all carry the LSN they describe
+                if (!inSnapshot) {
+                    if (e.lsn <= receivedLSN) continue;
+                    receivedLSN = e.lsn;
+                }
+                pending.push_back(std::move(e));
+            }
+            held = receivedLSN;
+        }
+        // Queued entries are applied before any promotion, so they count
+        // as held; a snapshot only once it is complete
+        if (!partial) acknowledge(held);
+    }
+
+    connected = false;
+    if (stopping || resyncNeeded) return;
+    if (partial) {
+        // Half a state cannot be topped up, only replaced
+        resyncNeeded = true;
+        return;
+    }
+    if (!synced) return;
+    if (clean) {
+        primaryClosed = true;
+    } else {
+        lostAt = chrono::steady_clock::now();
+        primaryLost = true;
+    }
+}
+
+size_t LogReceiver::take(vector<LogEntry>& out) {
+    out.clear();
+    lock_guard<mutex> guard(lock);
+    out.reserve(pending.size());
+    for (LogEntry& e : pending) out.push_back(std::move(e));
+    pending.clear();
+    if (!out.empty()) appliedLSN = out.back().lsn;
+    return out.size();
+}
+
+void LogReceiver::acknowledge(unsigned long long lsn) {
+    lock_guard<mutex> guard(connLock);
+    if (lsn > ackWanted) ackWanted = lsn;
+    flushAck();
+}
+
+// Caller holds connLock. Sends without blocking: first the rest of an ack
+// already started, then the newest one. Returns true if something is left
+// for when the socket has room (the reader thread polls for that).
+bool LogReceiver::flushAck() {
+    // Not before the handshake is through: the primary reads our LSN first
+    if (connFd < 0 || !connected) return false;
+    while (ackSent > 0 || ackWanted > ackLoaded) {
+        // A new ack is committed to once its first byte is out
+        if (ackSent == 0) memcpy(ackBuf, &ackWanted, sizeof(ackBuf));
+        ssize_t n = send(connFd, ackBuf + ackSent, sizeof(ackBuf) - ackSent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return true;
+        if (ackSent == 0) ackLoaded = ackWanted;
+        ackSent += n;
+        if (ackSent == sizeof(ackBuf)) ackSent = 0;
+    }
+    return false;
+}
+
+chrono::steady_clock::time_point LogReceiver::lostTime() {
+    return lostAt;
+}
@@ -0,0 +1,208 @@
+#ifndef REPLICATION_LOG_H
+#define REPLICATION_LOG_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include "MinHeap.h"
+
+using namespace std;
+
+// Log shipping to a warm standby (hospital_gui --standby).
+//
+// The primary appends every mutation to an in-memory log with a sequence
+// number (LSN). A sender thread connects to the standby's Unix socket and
+// streams the log in batches without waiting for acknowledgements. The
+// standby's reader thread queues each batch and acknowledges the last LSN
+// it holds; its GUI thread applies the queue once per frame, and applies
+// all of it before a promotion. On reconnect the standby reports what it
+// already has, so the primary resumes from there.
+//
+// A standby starts empty. On its first connection the primary's GUI thread
+// writes its whole state out as log entries (a snapshot, see
+// provideSnapshot) and the log streams on from there, so a standby never
+// depends on which files it was started next to.
+//
+// The primary keeps only what a standby may still ask for: entries up to
+// the last acknowledged LSN are dropped, and without a standby the log is
+// capped at LOG_RETAINED_ENTRIES. A standby that reconnects after its next
+// entry was dropped is told to resync and starts over from a snapshot.
+//
+// Wire format (host byte order, both ends are on one machine):
+//   primary -> standby  u64 session, u64 LSN the stream continues after,
+//                       then frames [u32 bytes][u32 count][entries]
+//   standby -> primary  u64 LSN received on connect (0 = wants a snapshot),
+//                       then u64 acks
+// Frame counts: 0 = clean shutdown, SNAPSHOT_FRAME | n = n snapshot
+// entries, SNAPSHOT_END = snapshot complete, RESYNC_FRAME = start over.
+
+const char* const STANDBY_SOCKET = "hospital_standby.sock";
+const size_t LOG_RETAINED_ENTRIES = 1 << 18;
+const unsigned int SNAPSHOT_FRAME = 0x80000000u;
+const unsigned int SNAPSHOT_END = 0xFFFFFFFFu;
+const unsigned int RESYNC_FRAME = 0xFFFFFFFEu;
+
+// Snapshots are made of LOG_STATE (aging policy and counters), LOG_REGISTER
+// for waiting patients and LOG_RECORD for everyone else in memory
+enum LogOp { LOG_REGISTER = 1, LOG_TREAT = 2, LOG_AGING = 3, LOG_UPDATE = 4, LOG_DELETE = 5,
+             LOG_STATE = 6, LOG_RECORD = 7 };
+
+// ACK_ASYNC: appends never wait, acks only track standby lag.
+// ACK_SYNC: sync() waits until the standby process holds everything
+// appended (received and queued, not yet necessarily applied). A confirmed
+// operation therefore survives a crash of the primary: the standby applies
+// its whole queue before it takes over. It does not survive losing both
+// processes, nothing is on disk on the standby. The wait is one round trip
+// over the socket, not a standby frame.
+enum AckMode { ACK_ASYNC = 0, ACK_SYNC = 1 };
+
+struct LogEntry {
+    unsigned long long lsn;
+    int op;
+    int patientID;
+    int age;
+    int priority;
+    int department;
+    long long admissionTime;
+    unsigned long long seq;  // queue sequence, so keys match the primary's
+    AgingPolicy aging;       // LOG_AGING only
+    string name;
+    string symptoms;
+
+    LogEntry() : lsn(0), op(0), patientID(0), age(0), priority(3), department(0),
+                 admissionTime(0), seq(0) {}
+};
+
+class LogShipper {
+private:
+    string path;
+    AckMode mode;
+    unsigned long long session;
+
+    thread sender;
+    mutex lock;
+    condition_variable acked;
+    deque<LogEntry> log;             // entry i has LSN baseLSN + i + 1
+    unsigned long long baseLSN;
+    unsigned long long ackedLSN;
+    bool stopping;
+    bool goodbye;
+    atomic<bool> connected;
+    // sync() writes a byte here so the sender goes now instead of
+    // gathering more appends for 2 ms
+    int wakePipe[2];
+
+    // A fresh standby waits in serve() until the appending thread hands
+    // over its state
+    bool snapshotWanted;
+    bool snapshotReady;
+    vector<LogEntry> snapshot;
+    unsigned long long snapshotLSN;
+
+    void run();
+    bool serve(int fd);
+    void trim();
+    bool sendResync(int fd);
+
+public:
+    LogShipper();
+    ~LogShipper() { stop(false); }
+    LogShipper(const LogShipper&) = delete;
+    LogShipper& operator=(const LogShipper&) = delete;
+
+    void start(const string& socketPath, AckMode ackMode);
+    // sendGoodbye tells the standby this was a clean shutdown, not a crash
+    void stop(bool sendGoodbye);
+
+    // Assigns and returns the entry's LSN
+    unsigned long long append(LogEntry entry);
+    // Appends (and empties) a batch under one lock; returns the last LSN
+    unsigned long long appendBatch(vector<LogEntry>& entries);
+    // ACK_SYNC: waits until the standby holds everything appended so far
+    // (see AckMode). Returns false on timeout or with no standby connected.
+    bool sync(int timeoutMillis = 500);
+
+    // A fresh standby is waiting for the primary's state
+    bool snapshotRequested();
+    // Called by the appending thread with its whole state as log entries;
+    // the standby then continues with whatever is appended after
+    void provideSnapshot(vector<LogEntry>& entries);
+
+    AckMode getMode() const { return mode; }
+    bool isConnected() const { return connected; }
+    unsigned long long lastLSN();
+    unsigned long long lastAcked();
+    // Entries still held for a standby
+    size_t retainedEntries();
+};
+
+class LogReceiver {
+private:
+    string path;
+    int listenFd;
+    int connFd;
+    mutex connLock;     // guards connFd and the ack state below
+    // Acks are cumulative, so only the newest one is kept. One that did not
+    // fit in the socket is finished before the next, or the primary would
+    // read the rest of the stream misaligned.
+    unsigned long long ackWanted;
+    unsigned long long ackLoaded;   // last ack started
+    char ackBuf[sizeof(unsigned long long)];
+    size_t ackSent;                 // bytes of ackBuf already sent
+    thread worker;
+    atomic<bool> stopping;
+
+    mutex lock;
+    deque<LogEntry> pending;
+    unsigned long long session;     // primary session being followed, 0 = none
+    unsigned long long receivedLSN; // last entry queued for the GUI thread
+    atomic<unsigned long long> appliedLSN; // last entry taken
+    atomic<bool> connected;
+    atomic<bool> synced;        // has a complete snapshot (or resumed)
+    atomic<bool> resyncNeeded;
+    atomic<bool> primaryLost;
+    atomic<bool> primaryClosed;
+    atomic<bool> sessionMismatch;
+    chrono::steady_clock::time_point lostAt;
+
+    void run();
+    void follow(int fd);
+    bool flushAck();
+
+public:
+    LogReceiver();
+    ~LogReceiver() { stop(); }
+    LogReceiver(const LogReceiver&) = delete;
+    LogReceiver& operator=(const LogReceiver&) = delete;
+
+    bool start(const string& socketPath);
+    void stop();
+
+    // Moves received entries into out, oldest first, for the caller to
+    // apply right away
+    size_t take(vector<LogEntry>& out);
+    // Tells the primary everything up to lsn is held here. The reader
+    // thread calls it for each batch it queues; it never blocks.
+    void acknowledge(unsigned long long lsn);
+
+    unsigned long long getAppliedLSN() const { return appliedLSN; }
+    bool isConnected() const { return connected; }
+    // The connection dropped without a clean shutdown: the primary crashed.
+    // A standby that never completed a snapshot has nothing to take over.
+    bool lost() const { return primaryLost; }
+    chrono::steady_clock::time_point lostTime();
+    bool primaryShutDown() const { return primaryClosed; }
+    // A restarted primary started a new log this standby cannot follow
+    bool sessionRejected() const { return sessionMismatch; }
+    bool isSynced() const { return synced; }
+    // The standby's state cannot be continued (a snapshot broke off, or the
+    // primary changed); it has to start empty again
+    bool needsRestart() const { return resyncNeeded || sessionMismatch; }
+};
+
+#endif
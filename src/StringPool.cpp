@@ -0,0 +1,99 @@
+#include "StringPool.h"
+#include <cstring>
+#include <utility>
+
+StringPool::StringPool() : chunkUsed(CHUNK_SIZE), arenaBytes(0) {
+    table.assign(1024, 0);
+    intern(""); // ID 0 is always the empty string
+}
+
+StringPool::~StringPool() {
+    for (char* c : chunks) delete[] c;
+}
+
+void StringPool::swap(StringPool& other) {
+    chunks.swap(other.chunks);
+    std::swap(chunkUsed, other.chunkUsed);
+    entries.swap(other.entries);
+    table.swap(other.table);
+    std::swap(arenaBytes, other.arenaBytes);
+}
+
+// FNV-1a
+unsigned int StringPool::hashText(const char* s, size_t len) {
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+const char* StringPool::store(const char* s, size_t len) {
+    size_t need = len + 1;
+    if (need > CHUNK_SIZE) {
+        // Oversized strings get a chunk of their own
+        char* big = new char[need];
+        chunks.insert(chunks.end() - (chunks.empty() ? 0 : 1), big);
+        memcpy(big, s, len);
+        big[len] = '\0';
+        arenaBytes += need;
+        return big;
+    }
+    if (chunkUsed + need > CHUNK_SIZE) {
+        chunks.push_back(new char[CHUNK_SIZE]);
+        chunkUsed = 0;
+        arenaBytes += CHUNK_SIZE;
+    }
+    char* dst = chunks.back() + chunkUsed;
+    memcpy(dst, s, len);
+    dst[len] = '\0';
+    chunkUsed += need;
+    return dst;
+}
+
+void StringPool::grow() {
+    vector<unsigned int> old;
+    old.swap(table);
+    table.assign(old.size() * 2, 0);
+    size_t mask = table.size() - 1;
+
+    for (unsigned int slot : old) {
+        if (slot == 0) continue;
+        const char* s = entries[slot - 1];
+        size_t i = hashText(s, strlen(s)) & mask;
+        while (table[i] != 0) i = (i + 1) & mask;
+        table[i] = slot;
+    }
+}
+
+unsigned int StringPool::intern(const char* s, size_t len) {
+    size_t mask = table.size() - 1;
+    size_t i = hashText(s, len) & mask;
+
+    while (table[i] != 0) {
+        const char* existing = entries[table[i] - 1];
+        if (strncmp(existing, s, len) == 0 && existing[len] == '\0')
+            return table[i] - 1;
+        i = (i + 1) & mask;
+    }
+
+    unsigned int id = entries.size();
+    entries.push_back(store(s, len));
+    table[i] = id + 1;
+
+    // Keep load factor under 70%
+    if (entries.size() * 10 > table.size() * 7) grow();
+    return id;
+}
+
+const char* StringPool::get(unsigned int id) const {
+    if (id >= entries.size()) return "";
+    return entries[id];
+}
+
+size_t StringPool::memoryUsage() const {
+    return arenaBytes
+         + entries.capacity() * sizeof(const char*)
+         + table.capacity() * sizeof(unsigned int);
+}
@@ -0,0 +1,51 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+using namespace std;
+
+// Interned string pool (dictionary encoding).
+// Every distinct string is stored once in a chunked arena and identified by a
+// 32-bit ID. Chunks never move, so pointers returned by get() stay valid
+// until the pool is destroyed or its contents are swapped out. Interning
+// never invalidates them.
+class StringPool {
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    vector<char*> chunks;
+    size_t chunkUsed;
+    vector<const char*> entries;   // ID -> text in the arena
+    vector<unsigned int> table;    // open addressing, holds ID + 1 (0 = empty)
+    size_t arenaBytes;
+
+    static unsigned int hashText(const char* s, size_t len);
+    const char* store(const char* s, size_t len);
+    void grow();
+
+public:
+    StringPool();
+    ~StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Exchanges contents. Pointers into the old contents go with them and
+    // die with the other pool.
+    void swap(StringPool& other);
+
+    // Returns the ID of s, adding it to the pool if it is new.
+    // Only a new string allocates, and only when its arena chunk is full.
+    unsigned int intern(const char* s, size_t len);
+    unsigned int intern(const char* s) { return intern(s, strlen(s)); }
+    unsigned int intern(const string& s) { return intern(s.data(), s.size()); }
+    const char* get(unsigned int id) const;
+
+    size_t size() const { return entries.size(); }
+    size_t memoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,238 @@
+#include "TreatmentDispatcher.h"
+#include <chrono>
+
+const char* departmentName(int dept) {
+    switch (dept) {
+        case TRAUMA: return "Trauma";
+        case PEDIATRICS: return "Pediatrics";
+        default: return "General";
+    }
+}
+
+TreatmentDispatcher::TreatmentDispatcher() : running(false), treatMillis(0) {}
+
+TreatmentDispatcher::~TreatmentDispatcher() {
+    stopStations();
+}
+
+// Caller holds s.lock
+void TreatmentDispatcher::publishTop(Shard& s) {
+    if (s.heap.isEmpty()) {
+        s.top.store(EMPTY_KEY, memory_order_release);
+        return;
+    }
+    s.top.store(s.heap.peek().key, memory_order_release);
+}
+
+unsigned long long TreatmentDispatcher::topSeq(int dept) {
+    Shard& s = shards[dept];
+    lock_guard<mutex> guard(s.lock);
+    return s.heap.isEmpty() ? ~0ull : s.heap.peek().seq;
+}
+
+int TreatmentDispatcher::chooseShard(int home) {
+    // One load per shard: key and priority can't disagree
+    unsigned long long tops[DEPARTMENTS];
+    int best = -1;
+    unsigned long long bestKey = EMPTY_KEY;
+    bool tie = false;
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        unsigned long long k = tops[d] = shards[d].top.load(memory_order_acquire);
+        if (k < bestKey) {
+            best = d;
+            bestKey = k;
+            tie = false;
+        } else if (k == bestKey && k != EMPTY_KEY) {
+            tie = true;
+        }
+    }
+
+    // Equal keys (e.g. a mass intake in one second): the earliest arrival
+    // wins, which needs a look at the tied heads
+    if (tie) {
+        unsigned long long bestSeq = topSeq(best);
+        for (int d = best + 1; d < DEPARTMENTS; d++) {
+            if (tops[d] != bestKey) continue;
+            unsigned long long seq = topSeq(d);
+            if (seq < bestSeq) {
+                best = d;
+                bestSeq = seq;
+            }
+        }
+    }
+
+    // Stay home when no shard's top is a more urgent level than the home top
+    if (best < 0 || home < 0 || home == best || tops[home] == EMPTY_KEY) return best;
+    int homePriority = AgingPolicy::priorityOf(tops[home]);
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        if (tops[d] != EMPTY_KEY && AgingPolicy::priorityOf(tops[d]) < homePriority) return best;
+    }
+    return home;
+}
+
+void TreatmentDispatcher::push(int dept, const QueueEntry& e) {
+    if (dept < 0 || dept >= DEPARTMENTS) dept = GENERAL;
+    Shard& s = shards[dept];
+    lock_guard<mutex> guard(s.lock);
+    s.heap.insert(e);
+    publishTop(s);
+}
+
+void TreatmentDispatcher::pushBulk(int dept, vector<QueueEntry>&& entries) {
+    if (dept < 0 || dept >= DEPARTMENTS) dept = GENERAL;
+    Shard& s = shards[dept];
+    lock_guard<mutex> guard(s.lock);
+    s.heap.merge(std::move(entries));
+    publishTop(s);
+}
+
+bool TreatmentDispatcher::pull(int home, QueueEntry& out, int* fromShard) {
+    while (true) {
+        int d = chooseShard(home);
+        if (d < 0) return false;
+
+        Shard& s = shards[d];
+        lock_guard<mutex> guard(s.lock);
+        if (s.heap.isEmpty()) {
+            // Raced with another station; look again
+            publishTop(s);
+            continue;
+        }
+        out = s.heap.extractMin();
+        publishTop(s);
+        if (fromShard) *fromShard = d;
+        return true;
+    }
+}
+
+QueueEntry TreatmentDispatcher::peekBest() {
+    while (true) {
+        int d = chooseShard(-1);
+        if (d < 0) return {3, -1, 0, 0};
+
+        Shard& s = shards[d];
+        lock_guard<mutex> guard(s.lock);
+        if (!s.heap.isEmpty()) return s.heap.peek();
+    }
+}
+
+bool TreatmentDispatcher::remove(int handle) {
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        Shard& s = shards[d];
+        lock_guard<mutex> guard(s.lock);
+        int position = s.heap.positionOf(handle);
+        if (position < 0) continue;
+        s.heap.removeAt(position);
+        publishTop(s);
+        return true;
+    }
+    return false;
+}
+
+bool TreatmentDispatcher::update(int handle, const function<void(QueueEntry&)>& edit) {
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        Shard& s = shards[d];
+        lock_guard<mutex> guard(s.lock);
+        int position = s.heap.positionOf(handle);
+        if (position < 0) continue;
+        edit(s.heap.at(position));
+        s.heap.resift(position);
+        publishTop(s);
+        return true;
+    }
+    return false;
+}
+
+int TreatmentDispatcher::rewrite(const function<bool(QueueEntry&)>& edit) {
+    int dropped = 0;
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        Shard& s = shards[d];
+        lock_guard<mutex> guard(s.lock);
+        vector<QueueEntry> entries = s.heap.getEntries();
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (edit(entries[i])) entries[kept++] = entries[i];
+        }
+        dropped += entries.size() - kept;
+        entries.resize(kept);
+        s.heap.assign(std::move(entries));
+        publishTop(s);
+    }
+    return dropped;
+}
+
+vector<QueueEntry> TreatmentDispatcher::snapshot(int dept) {
+    Shard& s = shards[dept];
+    lock_guard<mutex> guard(s.lock);
+    return s.heap.getEntries();
+}
+
+void TreatmentDispatcher::restore(int dept, vector<QueueEntry>&& entries) {
+    if (dept < 0 || dept >= DEPARTMENTS) dept = GENERAL;
+    Shard& s = shards[dept];
+    lock_guard<mutex> guard(s.lock);
+    s.heap.assign(std::move(entries));
+    publishTop(s);
+}
+
+void TreatmentDispatcher::rekey(const function<unsigned long long(const QueueEntry&)>& keyFn) {
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        Shard& s = shards[d];
+        lock_guard<mutex> guard(s.lock);
+        vector<QueueEntry> entries = s.heap.getEntries();
+        for (QueueEntry& e : entries) e.key = keyFn(e);
+        s.heap.assign(std::move(entries));
+        publishTop(s);
+    }
+}
+
+int TreatmentDispatcher::size() {
+    int total = 0;
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        lock_guard<mutex> guard(shards[d].lock);
+        total += shards[d].heap.size();
+    }
+    return total;
+}
+
+void TreatmentDispatcher::stationLoop(int dept) {
+    while (running.load()) {
+        QueueEntry e;
+        int from = dept;
+        if (!pull(dept, e, &from)) {
+            this_thread::sleep_for(chrono::milliseconds(5));
+            continue;
+        }
+
+        stationStats[dept].treated++;
+        if (from != dept) stationStats[dept].stolen++;
+        if (treatMillis > 0) this_thread::sleep_for(chrono::milliseconds(treatMillis));
+
+        lock_guard<mutex> guard(completedLock);
+        completed.push_back(e);
+    }
+}
+
+void TreatmentDispatcher::startStations(const int perDept[DEPARTMENTS], int treatmentMillis) {
+    stopStations();
+    treatMillis = treatmentMillis;
+    running = true;
+    for (int d = 0; d < DEPARTMENTS; d++) {
+        for (int i = 0; i < perDept[d]; i++) {
+            stations.push_back(thread(&TreatmentDispatcher::stationLoop, this, d));
+        }
+    }
+}
+
+void TreatmentDispatcher::stopStations() {
+    running = false;
+    for (thread& t : stations) t.join();
+    stations.clear();
+}
+
+vector<QueueEntry> TreatmentDispatcher::takeCompleted() {
+    vector<QueueEntry> done;
+    lock_guard<mutex> guard(completedLock);
+    done.swap(completed);
+    return done;
+}
@@ -0,0 +1,100 @@
+#ifndef TREATMENT_DISPATCHER_H
+#define TREATMENT_DISPATCHER_H
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "MinHeap.h"
+
+using namespace std;
+
+enum Department { GENERAL = 0, TRAUMA = 1, PEDIATRICS = 2 };
+const int DEPARTMENTS = 3;
+
+const char* departmentName(int dept);
+
+// Emergency queue sharded by department.
+// Each shard has its own heap and lock and publishes the key of its most
+// urgent entry in one atomic (the key carries the priority level), so a pull
+// can compare all shards without a global lock. A pull takes the smallest
+// key across shards (the earliest arrival among equal keys), but stays in
+// its home shard when no other shard's top has a higher priority; idle
+// stations steal from the shard with the most urgent top. Staying home
+// therefore never serves a lower priority while a higher one waits.
+class TreatmentDispatcher {
+private:
+    static const unsigned long long EMPTY_KEY = ~0ull;
+
+    struct Shard {
+        mutex lock;
+        EmergencyHeap heap;
+        atomic<unsigned long long> top;
+        Shard() : top(EMPTY_KEY) {}
+    };
+
+    struct StationStats {
+        atomic<int> treated;
+        atomic<int> stolen;
+        StationStats() : treated(0), stolen(0) {}
+    };
+
+    Shard shards[DEPARTMENTS];
+    StationStats stationStats[DEPARTMENTS];
+
+    // Worker threads simulating treatment stations
+    vector<thread> stations;
+    atomic<bool> running;
+    int treatMillis;
+
+    mutex completedLock;
+    vector<QueueEntry> completed;
+
+    void publishTop(Shard& s);
+    unsigned long long topSeq(int dept);
+    int chooseShard(int home);
+    void stationLoop(int dept);
+
+public:
+    TreatmentDispatcher();
+    ~TreatmentDispatcher();
+
+    void push(int dept, const QueueEntry& e);
+    // Many arrivals for one department under one lock (see MinHeap::merge)
+    void pushBulk(int dept, vector<QueueEntry>&& entries);
+    // home < 0 pulls the globally most urgent patient. Returns false if empty.
+    bool pull(int home, QueueEntry& out, int* fromShard = nullptr);
+    QueueEntry peekBest();
+    // Takes a specific patient out of the queue (log replay, deletion).
+    // O(log n): each shard's heap indexes its entries by handle.
+    bool remove(int handle);
+    // Edits a waiting patient's entry (e.g. retriage) and re-sifts it in
+    // O(log n). edit must keep the handle. Returns false if the patient is
+    // not waiting.
+    bool update(int handle, const function<void(QueueEntry&)>& edit);
+    // Batch form of remove/update: edit may change an entry or return false
+    // to drop it, and each shard is rebuilt once, O(n). Returns the number
+    // of entries dropped.
+    int rewrite(const function<bool(QueueEntry&)>& edit);
+
+    // Copy of one shard's entries (heap order)
+    vector<QueueEntry> snapshot(int dept);
+    // Replaces a shard's entries with a saved heap image, O(n)
+    void restore(int dept, vector<QueueEntry>&& entries);
+    // Recomputes every key (used when the aging policy changes)
+    void rekey(const function<unsigned long long(const QueueEntry&)>& keyFn);
+    int size();
+
+    // Stations: perDept[d] worker threads for department d
+    void startStations(const int perDept[DEPARTMENTS], int treatmentMillis);
+    void stopStations();
+    bool stationsRunning() const { return running; }
+    int treatedBy(int dept) const { return stationStats[dept].treated; }
+    int stolenBy(int dept) const { return stationStats[dept].stolen; }
+
+    // Patients finished by stations since the last call
+    vector<QueueEntry> takeCompleted();
+};
+
+#endif
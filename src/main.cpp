@@ -7,121 +7,73 @@
 #include <ctime>
 #include <cstring>
 #include <cstdio>
-#include "MinHeap.h"
-#include "PatientRecordsBST.h"
+#include <chrono>
+#include <cfloat>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include "BackendInterface.h"
 
-// Backend Integration Class
-class BackendInterface {
-private:
-    MinHeap priorityQueue;
-    PatientRecordsBST patientRecords;
-    int nextPatientID = 1001;
-    
-public:
-BackendInterface() {
-    // Try to load existing data
-    patientRecords.loadFromFile("patients.csv");
-    
-    // Set next ID based on loaded data
-    auto records = patientRecords.getAllPatients();
-    if (!records.empty()) {
-        int maxID = 1000;
-        for (const auto& p : records) {
-            if (p.patientID > maxID) maxID = p.patientID;
-        }
-        nextPatientID = maxID + 1;
-    }
-}
-    
-    ~BackendInterface() {
-        // Auto-save on exit
-        patientRecords.saveToFile("patients.csv");
-    }
-    
-    void addPatient(const Patient& p) {
-        // Add to priority queue (MinHeap)
-        priorityQueue.insert(p);
-        
-        // Add to BST for searching
-        PatientData pd;
-        pd.patientID = p.id;
-        pd.name = p.name;
-        pd.age = p.age;
-        pd.symptoms = p.symptoms;
-        pd.priorityLevel = p.priority;
-        patientRecords.insertPatient(pd);
-    }
-    
-    std::vector<Patient> getQueuedPatients() {
-        return priorityQueue.getPatients();
-    }
-    
-    Patient* searchPatient(int id) {
-        PatientData* pd = patientRecords.searchPatient(id);
-        if (pd != nullptr) {
-            static Patient p;
-            p.id = pd->patientID;
-            p.name = pd->name;
-            p.age = pd->age;
-            p.symptoms = pd->symptoms;
-            p.priority = pd->priorityLevel;
-            return &p;
-        }
-        return nullptr;
-    }
-    
-    int getTotalPatients() {
-        return priorityQueue.getPatients().size();
-    }
-    
-    int getPatientsByPriority(int priority) {
-        int count = 0;
-        for (const auto& p : priorityQueue.getPatients()) {
-            if (p.priority == priority) count++;
-        }
-        return count;
-    }
-    
-    int getNextID() {
-        return nextPatientID++;
-    }
-    
-    Patient getNextPatient() {
-        return priorityQueue.peek();
-    }
-    
-    void treatNextPatient() {
-        priorityQueue.extractMin();
-    }
-    
-    void saveToFile() {
-        patientRecords.saveToFile("patients.csv");
-    }
-    
-    std::vector<PatientData> getAllRecords() {
-        return patientRecords.getAllPatients();
-    }
-};
+// Time window filter for the records screen
+static const char* RECORD_WINDOW_LABELS[] = { "All time", "Last hour", "Last 6 hours", "Last 24 hours", "Last 7 days" };
+static const long long RECORD_WINDOW_SECONDS[] = { 0, 3600, 6 * 3600, 24 * 3600, 7 * 24 * 3600 };
 
 // GUI Manager Class
 class GUIManager {
 private:
     BackendInterface& backend;
-    enum Screen { DASHBOARD, REGISTER, QUEUE, SEARCH, RECORDS };
+    enum Screen { DASHBOARD, REGISTER, QUEUE, SEARCH, RECORDS, ARCHIVE };
     Screen currentScreen = DASHBOARD;
     
     char nameInput[128] = "";
     char ageInput[16] = "";
     char symptomsInput[256] = "";
     int selectedPriority = 2;
+    int selectedDepartment = GENERAL;
+    
+    char intakeInput[64 * 1024] = "";
+    char intakeFile[256] = "intake.csv";
+    char intakeMessage[160] = "";
+    std::vector<std::string> intakeErrors;
+    // The last registered batch, IDs lastIntakeFirst .. + lastIntakeCount - 1
+    int lastIntakeFirst = -1;
+    int lastIntakeCount = 0;
+    int intakePriority = 1;
+    bool confirmUndoIntake = false;
+    
+    int stationCounts[DEPARTMENTS] = { 2, 1, 1 };
+    int treatmentSeconds = 5;
     char statusMessage[256] = "";
     bool showStatus = false;
     float statusTimer = 0.0f;
     
     char searchIDInput[16] = "";
-    Patient* searchResult = nullptr;
+    PatientRecord searchResult;
+    bool searchFound = false;
     bool searchPerformed = false;
     
+    // Correction form for the record found by the search
+    char editName[128] = "";
+    char editAge[16] = "";
+    char editSymptoms[256] = "";
+    int editPriority = 2;
+    bool confirmDelete = false;
+    char editMessage[128] = "";
+    
+    int recordsWindow = 0; // index into RECORD_WINDOWS
+    
+    char archiveFromID[16] = "";
+    char archiveToID[16] = "";
+    bool archivePriority[3] = { true, true, true };
+    std::vector<PatientRecord> archiveResults;
+    int archiveGroupsRead = 0;
+    int archiveGroupsSkipped = 0;
+    double archiveMillis = 0.0;
+    bool archiveScanned = false;
+    
+    bool failoverReported = false;
+    bool restoreReported = false;
+    
     // Larger fonts
     ImFont* headerFont = nullptr;
     ImFont* normalFont = nullptr;
@@ -130,6 +82,26 @@ public:
     GUIManager(BackendInterface& be) : backend(be) {}
     
     void render() {
+        backend.poll();
+        if (backend.isStandby()) {
+            renderStandby();
+            return;
+        }
+        if (backend.getFailoverMillis() >= 0 && !failoverReported) {
+            snprintf(statusMessage, sizeof(statusMessage),
+                     "⚠ Primary lost: this standby took over in %.0f ms", backend.getFailoverMillis());
+            showStatus = true;
+            statusTimer = 0.0f;
+            failoverReported = true;
+        }
+        if (backend.getRestoreMillis() >= 0 && !restoreReported) {
+            snprintf(statusMessage, sizeof(statusMessage),
+                     "✓ Restored %d waiting patients from the last checkpoint in %.0f ms",
+                     backend.getRestoredCount(), backend.getRestoreMillis());
+            showStatus = true;
+            statusTimer = 0.0f;
+            restoreReported = true;
+        }
         renderMenuBar();
         
         // Fancy main window with larger size
@@ -148,12 +120,29 @@ public:
             }
         }
         
+        // Registration and the queue work while records load; lists and
+        // search fill in as batches arrive
+        if (backend.isLoading()) {
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "Loading patient records... %d%%",
+                     (int)(backend.getLoadProgress() * 100));
+            ImGui::ProgressBar(backend.getLoadProgress(), ImVec2(-1, 0), overlay);
+            ImGui::Spacing();
+        }
+        if (backend.getSkippedRows() > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f),
+                               "⚠ %d malformed rows in patients.csv were skipped; it is kept as is and saves go to %s",
+                               backend.getSkippedRows(), backend.getSavePath());
+            ImGui::Spacing();
+        }
+        
         switch (currentScreen) {
             case DASHBOARD: renderDashboard(); break;
             case REGISTER: renderRegistration(); break;
             case QUEUE: renderQueue(); break;
             case SEARCH: renderSearch(); break;
             case RECORDS: renderAllRecords(); break;
+            case ARCHIVE: renderArchive(); break;
         }
         
         ImGui::End();
@@ -177,12 +166,20 @@ private:
             if (ImGui::MenuItem("📁 All Records", nullptr, currentScreen == RECORDS)) {
                 currentScreen = RECORDS;
             }
+            if (ImGui::MenuItem("📦 Archive", nullptr, currentScreen == ARCHIVE)) {
+                currentScreen = ARCHIVE;
+            }
             
             ImGui::Separator();
             
             if (ImGui::MenuItem("💾 Save Data")) {
-                backend.saveToFile();
-                strcpy(statusMessage, "✓ Data saved successfully!");
+                if (backend.saveToFile()) {
+                    snprintf(statusMessage, sizeof(statusMessage), "✓ Data saved to %s", backend.getSavePath());
+                } else if (backend.isLoading()) {
+                    strcpy(statusMessage, "✗ Records are still loading, try again shortly");
+                } else {
+                    strcpy(statusMessage, "✗ Error: Could not write patients.csv");
+                }
                 showStatus = true;
                 statusTimer = 0.0f;
             }
@@ -260,7 +257,7 @@ private:
         if (next.id != -1) {
             ImGui::SetWindowFontScale(1.2f);
             ImGui::Text("ID: %d", next.id);
-            ImGui::Text("Name: %s", next.name.c_str());
+            ImGui::Text("Name: %s", next.name);
             ImGui::Text("Age: %d", next.age);
             
             if (next.priority == 1) {
@@ -310,9 +307,163 @@ private:
         }
         ImGui::SetWindowFontScale(1.0f);
         
+        ImGui::Spacing();
+        renderAnalytics();
+        
+        ImGui::Spacing();
+        renderStations();
+        
+        ImGui::Spacing();
+        renderReplication();
+        
         ImGui::PopFont();
     }
     
+    void renderReplication() {
+        ImGui::BeginChild("Replication", ImVec2(0, 90), true, ImGuiWindowFlags_NoScrollbar);
+        ImGui::Text("🔁 Standby (%s acknowledgements)",
+                    backend.getAckMode() == ACK_SYNC ? "synchronous" : "asynchronous");
+        if (backend.standbyConnected()) {
+            ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "Connected, %llu log entries behind",
+                               backend.standbyLag());
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "No standby connected (start one with --standby)");
+        }
+        if (backend.checkpointFailing()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "✗ Cannot write %s; the queue will not survive a restart",
+                               QUEUE_CHECKPOINT);
+        }
+        ImGui::EndChild();
+    }
+    
+    // Shown instead of the normal screens until this process is promoted
+    void renderStandby() {
+        ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(1200, 800), ImGuiCond_Always);
+        ImGui::Begin("Standby", nullptr,
+                     ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+        
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.3f, 0.8f, 1.0f, 1.0f));
+        ImGui::SetWindowFontScale(1.8f);
+        ImGui::Text("🔁 Warm Standby");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::PopStyleColor();
+        ImGui::Separator();
+        ImGui::Spacing();
+        
+        const LogReceiver& receiver = backend.getReceiver();
+        ImGui::SetWindowFontScale(1.2f);
+        if (receiver.isConnected() && !receiver.isSynced()) {
+            ImGui::Text("Receiving the primary's state...");
+        } else if (receiver.isConnected()) {
+            ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "✓ Following the primary");
+        } else if (receiver.primaryShutDown()) {
+            ImGui::Text("Primary shut down cleanly; waiting for it to come back");
+        } else {
+            ImGui::Text("Waiting for the primary to connect...");
+        }
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::Spacing();
+        
+        ImGui::Text("Applied log entries: %llu", receiver.getAppliedLSN());
+        ImGui::Text("Waiting patients: %d", backend.getTotalPatients());
+        if (backend.isLoading()) {
+            ImGui::ProgressBar(backend.getLoadProgress(), ImVec2(400, 0), "Loading patient records");
+        }
+        ImGui::Spacing();
+        ImGui::Text("Takes over automatically if the primary crashes.");
+        
+        // Manual takeover, e.g. when the primary host hangs without closing
+        // its connection. Running two primaries would split the data.
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.7f, 0.3f, 0.2f, 1.0f));
+        if (ImGui::Button("Promote to primary", ImVec2(250, 40))) {
+            backend.promote();
+        }
+        ImGui::PopStyleColor();
+        
+        ImGui::End();
+    }
+    
+    void renderStations() {
+        ImGui::BeginChild("Stations", ImVec2(0, 200), true);
+        
+        ImGui::SetWindowFontScale(1.4f);
+        ImGui::Text("🩺 Treatment Stations");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::Separator();
+        
+        bool running = backend.stationsRunning();
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            ImGui::PushID(d);
+            ImGui::PushItemWidth(120);
+            ImGui::InputInt(departmentName(d), &stationCounts[d]);
+            ImGui::PopItemWidth();
+            if (stationCounts[d] < 0) stationCounts[d] = 0;
+            if (stationCounts[d] > 16) stationCounts[d] = 16;
+            ImGui::SameLine(300);
+            ImGui::Text("Treated: %d  (stolen from other departments: %d)",
+                        backend.getTreatedBy(d), backend.getStolenBy(d));
+            ImGui::PopID();
+        }
+        
+        ImGui::PushItemWidth(120);
+        ImGui::InputInt("Treatment time (s)", &treatmentSeconds);
+        ImGui::PopItemWidth();
+        if (treatmentSeconds < 0) treatmentSeconds = 0;
+        
+        if (!running) {
+            if (ImGui::Button("▶ Start Stations", ImVec2(200, 35))) {
+                backend.startStations(stationCounts, treatmentSeconds * 1000);
+            }
+        } else {
+            if (ImGui::Button("■ Stop Stations", ImVec2(200, 35))) {
+                backend.stopStations();
+            }
+        }
+        
+        ImGui::EndChild();
+    }
+    
+    void renderAnalytics() {
+        double millis = 0.0;
+        const DashboardStats& st = backend.getDashboardStats(millis);
+        
+        ImGui::BeginChild("Analytics", ImVec2(0, 300), true);
+        
+        ImGui::SetWindowFontScale(1.4f);
+        ImGui::Text("📈 Analytics (Waiting + Historical)");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::Separator();
+        ImGui::Text("Records: %u | Waiting: %u | Computed in %.2f ms (%s)",
+                    st.total, st.totalWaiting, millis, PatientColumns::kernelName());
+        ImGui::Text("Average age:  Critical %.1f  |  Urgent %.1f  |  Standard %.1f",
+                    st.avgAge[0], st.avgAge[1], st.avgAge[2]);
+        ImGui::Spacing();
+        
+        // Age band x priority histogram, waiting count in brackets
+        if (ImGui::BeginTable("AgeBandTable", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Age Band", ImGuiTableColumnFlags_WidthFixed, 120);
+            ImGui::TableSetupColumn("🔴 Critical");
+            ImGui::TableSetupColumn("🟠 Urgent");
+            ImGui::TableSetupColumn("🟢 Standard");
+            ImGui::TableHeadersRow();
+            
+            for (int b = 0; b < AGE_BANDS; b++) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", PatientColumns::ageBandLabel(b));
+                for (int p = 0; p < PRIORITY_LEVELS; p++) {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%u (%u)", st.histogram[b][p], st.waiting[b][p]);
+                }
+            }
+            
+            ImGui::EndTable();
+        }
+        
+        ImGui::EndChild();
+    }
+    
     void renderRegistration() {
         ImGui::SetWindowFontScale(1.5f);
         ImGui::Text("➕ Patient Registration");
@@ -320,7 +471,7 @@ private:
         ImGui::Separator();
         ImGui::Spacing();
         
-        ImGui::BeginChild("RegistrationForm", ImVec2(700, 580), true);
+        ImGui::BeginChild("RegistrationForm", ImVec2(700, 660), true);
         
         ImGui::SetWindowFontScale(1.2f);
         
@@ -373,6 +524,19 @@ private:
         ImGui::Spacing();
         ImGui::Spacing();
         
+        // Department
+        ImGui::SetWindowFontScale(1.2f);
+        ImGui::Text("Department:");
+        ImGui::SetWindowFontScale(1.1f);
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            if (d > 0) ImGui::SameLine();
+            ImGui::RadioButton(departmentName(d), &selectedDepartment, d);
+        }
+        ImGui::SetWindowFontScale(1.0f);
+        
+        ImGui::Spacing();
+        ImGui::Spacing();
+        
         // Submit Button
         ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.2f, 0.7f, 0.3f, 1.0f));
         if (ImGui::Button("✓ Submit Registration", ImVec2(250, 50))) {
@@ -396,13 +560,149 @@ private:
             ImGui::Spacing();
             ImGui::Spacing();
             ImGui::SetWindowFontScale(1.3f);
-            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 0.8f, 0.0f, 1.0f));
+            bool failed = strncmp(statusMessage, "✗", strlen("✗")) == 0;
+            ImGui::PushStyleColor(ImGuiCol_Text, failed ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImVec4(0.0f, 0.8f, 0.0f, 1.0f));
             ImGui::Text("%s", statusMessage);
             ImGui::PopStyleColor();
             ImGui::SetWindowFontScale(1.0f);
         }
         
         ImGui::EndChild();
+        
+        ImGui::SameLine();
+        renderMassIntake();
+    }
+    
+    // Mass-casualty intake: a pasted list or a CSV file registered as one batch
+    void renderMassIntake() {
+        ImGui::BeginChild("MassIntake", ImVec2(0, 660), true);
+        ImGui::SetWindowFontScale(1.2f);
+        ImGui::Text("🚑 Mass Casualty Intake");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::TextWrapped("One patient per line: name,age,symptoms,priority[,department]");
+        ImGui::Spacing();
+        
+        ImGui::InputTextMultiline("##intake", intakeInput, sizeof(intakeInput), ImVec2(-1, 300));
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.2f, 0.7f, 0.3f, 1.0f));
+        if (ImGui::Button("✓ Register List", ImVec2(180, 40))) {
+            std::vector<IntakeRow> rows;
+            intakeErrors.clear();
+            parseIntake(intakeInput, strlen(intakeInput), rows, intakeErrors);
+            registerIntake(rows);
+            if (intakeErrors.empty()) intakeInput[0] = '\0';
+        }
+        ImGui::PopStyleColor();
+        
+        ImGui::Spacing();
+        ImGui::Text("Or import a file:");
+        ImGui::PushItemWidth(260);
+        ImGui::InputText("##intakeFile", intakeFile, sizeof(intakeFile));
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        if (ImGui::Button("📂 Import")) {
+            std::vector<IntakeRow> rows;
+            intakeErrors.clear();
+            if (readIntakeFile(intakeFile, rows, intakeErrors)) {
+                registerIntake(rows);
+            } else {
+                snprintf(intakeMessage, sizeof(intakeMessage), "✗ Cannot read %s", intakeFile);
+            }
+        }
+        
+        ImGui::Spacing();
+        if (intakeMessage[0] != '\0') ImGui::TextWrapped("%s", intakeMessage);
+        const size_t SHOWN = 8;
+        for (size_t i = 0; i < intakeErrors.size() && i < SHOWN; i++) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", intakeErrors[i].c_str());
+        }
+        if (intakeErrors.size() > SHOWN) {
+            ImGui::Text("... and %d more", (int)(intakeErrors.size() - SHOWN));
+        }
+        
+        if (lastIntakeFirst >= 0) {
+            ImGui::Spacing();
+            ImGui::Separator();
+            ImGui::Text("Last intake: IDs %d-%d", lastIntakeFirst, lastIntakeFirst + lastIntakeCount - 1);
+            ImGui::RadioButton("Critical##intake", &intakePriority, 1);
+            ImGui::SameLine();
+            ImGui::RadioButton("Urgent##intake", &intakePriority, 2);
+            ImGui::SameLine();
+            ImGui::RadioButton("Standard##intake", &intakePriority, 3);
+            ImGui::SameLine();
+            if (ImGui::Button("↻ Retriage All")) {
+                retriageIntake();
+            }
+            ImGui::Checkbox("Confirm undo", &confirmUndoIntake);
+            ImGui::SameLine();
+            ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.7f, 0.2f, 0.2f, 1.0f));
+            if (ImGui::Button("↶ Undo Intake")) {
+                undoIntake();
+            }
+            ImGui::PopStyleColor();
+        }
+        ImGui::EndChild();
+    }
+    
+    // Gives every patient of the last batch still in memory the chosen priority
+    void retriageIntake() {
+        // Copies: interning the new text may move the pool under toPatient()'s pointers
+        std::vector<PatientRecord> records;
+        PatientRecord r;
+        for (int id = lastIntakeFirst; id < lastIntakeFirst + lastIntakeCount; id++) {
+            if (backend.searchPatient(id, r)) records.push_back(r);
+        }
+        std::vector<Patient> changes;
+        changes.reserve(records.size());
+        for (const PatientRecord& rec : records) {
+            Patient p = {rec.patientID, rec.name.c_str(), rec.age, rec.symptoms.c_str(), intakePriority, GENERAL};
+            changes.push_back(p);
+        }
+        int changed = backend.updatePatients(changes);
+        if (backend.isStandby()) {
+            snprintf(intakeMessage, sizeof(intakeMessage), "✗ Retriage is only possible on the primary");
+        } else {
+            snprintf(intakeMessage, sizeof(intakeMessage), "✓ Retriaged %d of %d patients (archived records are read-only)",
+                     changed, lastIntakeCount);
+        }
+    }
+    
+    // Removes a batch registered by mistake; patients being treated stay
+    void undoIntake() {
+        if (!confirmUndoIntake) {
+            snprintf(intakeMessage, sizeof(intakeMessage), "Tick 'Confirm undo' first");
+            return;
+        }
+        confirmUndoIntake = false;
+        std::vector<int> ids;
+        for (int id = lastIntakeFirst; id < lastIntakeFirst + lastIntakeCount; id++) ids.push_back(id);
+        int deleted = backend.deletePatients(ids);
+        if (backend.isStandby()) {
+            snprintf(intakeMessage, sizeof(intakeMessage), "✗ Undo is only possible on the primary");
+            return;
+        }
+        snprintf(intakeMessage, sizeof(intakeMessage), "✓ Removed %d of %d patients (archived ones and those being treated stay)",
+                 deleted, lastIntakeCount);
+        lastIntakeFirst = -1;
+        lastIntakeCount = 0;
+    }
+    
+    void registerIntake(const std::vector<IntakeRow>& rows) {
+        if (rows.empty()) {
+            snprintf(intakeMessage, sizeof(intakeMessage), "✗ No valid rows (%d rejected)", (int)intakeErrors.size());
+            return;
+        }
+        bool confirmed = false;
+        int first = backend.addPatientsBulk(rows, confirmed);
+        if (first < 0) {
+            snprintf(intakeMessage, sizeof(intakeMessage), "✗ Intake is only possible on the primary");
+            return;
+        }
+        lastIntakeFirst = first;
+        lastIntakeCount = (int)rows.size();
+        snprintf(intakeMessage, sizeof(intakeMessage), "✓ Registered %d patients, IDs %d-%d%s%s",
+                 (int)rows.size(), first, first + (int)rows.size() - 1,
+                 intakeErrors.empty() ? "" : ", some lines rejected",
+                 confirmed ? "" : " (standby did not confirm)");
     }
     
     void renderQueue() {
@@ -412,6 +712,9 @@ private:
         ImGui::Separator();
         ImGui::Spacing();
         
+        renderAgingPolicy();
+        ImGui::Spacing();
+        
         auto queue = backend.getQueuedPatients();
         
         if (queue.empty()) {
@@ -426,22 +729,25 @@ private:
         
         // Table display with larger font
         ImGui::SetWindowFontScale(1.1f);
-        if (ImGui::BeginTable("QueueTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 600))) {
+        if (ImGui::BeginTable("QueueTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 540))) {
             ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_WidthFixed, 80);
             ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthFixed, 200);
             ImGui::TableSetupColumn("Age", ImGuiTableColumnFlags_WidthFixed, 80);
             ImGui::TableSetupColumn("Priority", ImGuiTableColumnFlags_WidthFixed, 150);
+            ImGui::TableSetupColumn("Department", ImGuiTableColumnFlags_WidthFixed, 120);
+            ImGui::TableSetupColumn("Projected", ImGuiTableColumnFlags_WidthFixed, 110);
             ImGui::TableSetupColumn("Symptoms", ImGuiTableColumnFlags_WidthStretch);
             ImGui::TableHeadersRow();
             
-            for (const auto& patient : queue) {
+            for (int i = 0; i < (int)queue.size(); i++) {
+                const Patient& patient = queue[i];
                 ImGui::TableNextRow();
                 
                 ImGui::TableNextColumn();
                 ImGui::Text("%d", patient.id);
                 
                 ImGui::TableNextColumn();
-                ImGui::Text("%s", patient.name.c_str());
+                ImGui::Text("%s", patient.name);
                 
                 ImGui::TableNextColumn();
                 ImGui::Text("%d", patient.age);
@@ -460,7 +766,13 @@ private:
                 ImGui::PopStyleColor();
                 
                 ImGui::TableNextColumn();
-                ImGui::TextWrapped("%s", patient.symptoms.c_str());
+                ImGui::Text("%s", departmentName(patient.department));
+                
+                ImGui::TableNextColumn();
+                ImGui::Text("in ~%d min", (int)(backend.getProjectedWaitSeconds(i) / 60.0 + 0.5));
+                
+                ImGui::TableNextColumn();
+                ImGui::TextWrapped("%s", patient.symptoms);
             }
             
             ImGui::EndTable();
@@ -468,6 +780,24 @@ private:
         ImGui::SetWindowFontScale(1.0f);
     }
     
+    void renderAgingPolicy() {
+        AgingPolicy policy = backend.getAgingPolicy();
+        bool changed = ImGui::Checkbox("Wait-time aging", &policy.enabled);
+        if (policy.enabled) {
+            ImGui::SameLine();
+            ImGui::PushItemWidth(100);
+            changed |= ImGui::InputInt("Urgent offset (min)", &policy.offsetMinutes[2]);
+            ImGui::SameLine();
+            changed |= ImGui::InputInt("Standard offset (min)", &policy.offsetMinutes[3]);
+            ImGui::PopItemWidth();
+            if (policy.offsetMinutes[2] < 0) policy.offsetMinutes[2] = 0;
+            if (policy.offsetMinutes[3] < 0) policy.offsetMinutes[3] = 0;
+        }
+        if (changed) backend.setAgingPolicy(policy);
+        
+        ImGui::TextDisabled("A patient counts as arriving 'offset' minutes later than they did; critical patients always go first.");
+    }
+    
     void renderSearch() {
         ImGui::SetWindowFontScale(1.5f);
         ImGui::Text("🔍 Search Patient by ID");
@@ -493,8 +823,9 @@ private:
         
         if (ImGui::Button("✗ Clear", ImVec2(200, 50))) {
             searchIDInput[0] = '\0';
-            searchResult = nullptr;
+            searchFound = false;
             searchPerformed = false;
+            editMessage[0] = '\0';
         }
         
         ImGui::Spacing();
@@ -503,7 +834,7 @@ private:
         
         // Display search results
         if (searchPerformed) {
-            if (searchResult != nullptr) {
+            if (searchFound) {
                 ImGui::SetWindowFontScale(1.3f);
                 ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 0.8f, 0.0f, 1.0f));
                 ImGui::Text("✓ Patient Found");
@@ -514,15 +845,15 @@ private:
                 ImGui::Spacing();
                 
                 ImGui::SetWindowFontScale(1.2f);
-                ImGui::Text("ID: %d", searchResult->id);
-                ImGui::Text("Name: %s", searchResult->name.c_str());
-                ImGui::Text("Age: %d", searchResult->age);
+                ImGui::Text("ID: %d", searchResult.patientID);
+                ImGui::Text("Name: %s", searchResult.name.c_str());
+                ImGui::Text("Age: %d", searchResult.age);
                 
-                if (searchResult->priority == 1) {
+                if (searchResult.priorityLevel == 1) {
                     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.2f, 0.2f, 1.0f));
                     ImGui::Text("Priority: 🔴 CRITICAL");
                     ImGui::PopStyleColor();
-                } else if (searchResult->priority == 2) {
+                } else if (searchResult.priorityLevel == 2) {
                     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.6f, 0.0f, 1.0f));
                     ImGui::Text("Priority: 🟠 URGENT");
                     ImGui::PopStyleColor();
@@ -532,17 +863,100 @@ private:
                     ImGui::PopStyleColor();
                 }
                 
-                ImGui::Text("Symptoms: %s", searchResult->symptoms.c_str());
+                ImGui::Text("Symptoms: %s", searchResult.symptoms.c_str());
                 ImGui::SetWindowFontScale(1.0f);
             } else {
                 ImGui::SetWindowFontScale(1.3f);
                 ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.2f, 0.2f, 1.0f));
                 ImGui::Text("✗ Patient not found!");
+                if (backend.isLoading()) {
+                    ImGui::SetWindowFontScale(1.0f);
+                    ImGui::Text("Records are still loading (%d%%), try again shortly",
+                                (int)(backend.getLoadProgress() * 100));
+                }
                 ImGui::PopStyleColor();
                 ImGui::SetWindowFontScale(1.0f);
             }
         }
         
+        if (editMessage[0] != '\0') {
+            ImGui::Spacing();
+            ImGui::TextWrapped("%s", editMessage);
+        }
+        
+        ImGui::EndChild();
+        
+        if (searchPerformed && searchFound) {
+            ImGui::SameLine();
+            renderEditRecord();
+        }
+    }
+    
+    // Corrections and deletion for the record found by the search
+    void renderEditRecord() {
+        ImGui::BeginChild("EditRecord", ImVec2(0, 600), true);
+        ImGui::SetWindowFontScale(1.2f);
+        ImGui::Text("✏ Correct Record %d", searchResult.patientID);
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::Separator();
+        ImGui::Spacing();
+        
+        ImGui::Text("Name:");
+        ImGui::PushItemWidth(-1);
+        ImGui::InputText("##editName", editName, sizeof(editName));
+        ImGui::PopItemWidth();
+        ImGui::Text("Age:");
+        ImGui::PushItemWidth(120);
+        ImGui::InputText("##editAge", editAge, sizeof(editAge), ImGuiInputTextFlags_CharsDecimal);
+        ImGui::PopItemWidth();
+        ImGui::Text("Symptoms:");
+        ImGui::InputTextMultiline("##editSymptoms", editSymptoms, sizeof(editSymptoms), ImVec2(-1, 100));
+        ImGui::Text("Priority (a waiting patient is re-triaged):");
+        ImGui::RadioButton("Critical", &editPriority, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("Urgent", &editPriority, 2);
+        ImGui::SameLine();
+        ImGui::RadioButton("Standard", &editPriority, 3);
+        ImGui::Spacing();
+        
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.2f, 0.7f, 0.3f, 1.0f));
+        if (ImGui::Button("✓ Save Changes", ImVec2(200, 40))) {
+            if (strlen(editName) == 0 || atoi(editAge) <= 0 || strlen(editSymptoms) == 0) {
+                snprintf(editMessage, sizeof(editMessage), "✗ Name, a valid age and symptoms are required");
+            } else {
+                Patient p = {searchResult.patientID, editName, atoi(editAge), editSymptoms, editPriority, GENERAL};
+                if (backend.updatePatient(p)) {
+                    performSearch();
+                    snprintf(editMessage, sizeof(editMessage), "✓ Record %d updated", p.id);
+                } else {
+                    snprintf(editMessage, sizeof(editMessage), "✗ Only records in memory can be changed, on the primary");
+                }
+            }
+        }
+        ImGui::PopStyleColor();
+        
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+        ImGui::Checkbox("Confirm deletion", &confirmDelete);
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.7f, 0.2f, 0.2f, 1.0f));
+        if (ImGui::Button("🗑 Delete Record", ImVec2(200, 40))) {
+            int id = searchResult.patientID;
+            if (!confirmDelete) {
+                snprintf(editMessage, sizeof(editMessage), "Tick 'Confirm deletion' first");
+            } else if (backend.deletePatient(id)) {
+                snprintf(editMessage, sizeof(editMessage), "✓ Patient %d deleted", id);
+                searchFound = false;
+                searchPerformed = false;
+            } else {
+                snprintf(editMessage, sizeof(editMessage),
+                         "✗ Patient %d cannot be deleted (archived, being treated, or this is a standby)", id);
+            }
+            confirmDelete = false;
+        }
+        ImGui::PopStyleColor();
+        
         ImGui::EndChild();
     }
     
@@ -553,7 +967,27 @@ private:
         ImGui::Separator();
         ImGui::Spacing();
         
-        auto records = backend.getAllRecords();
+        // Arrivals per hour over the last 24h
+        std::vector<int> arrivals = backend.getArrivalsPerHour(24);
+        float arrivalValues[24];
+        for (int i = 0; i < 24; i++) arrivalValues[i] = (float)arrivals[i];
+        ImGui::Text("Arrivals per hour (last 24h):");
+        ImGui::PlotHistogram("##arrivals", arrivalValues, 24, 0, nullptr, 0.0f, FLT_MAX, ImVec2(600, 60));
+        
+        ImGui::Text("Admitted:");
+        ImGui::SameLine();
+        ImGui::PushItemWidth(200);
+        ImGui::Combo("##window", &recordsWindow, RECORD_WINDOW_LABELS, 5);
+        ImGui::PopItemWidth();
+        ImGui::Spacing();
+        
+        std::vector<PatientData> records;
+        if (recordsWindow == 0) {
+            records = backend.getAllRecords();
+        } else {
+            long long now = (long long)time(nullptr);
+            records = backend.getRecordsAdmittedBetween(now - RECORD_WINDOW_SECONDS[recordsWindow], now);
+        }
         
         if (records.empty()) {
             ImGui::SetWindowFontScale(1.3f);
@@ -562,15 +996,17 @@ private:
             return;
         }
         
-        ImGui::Text("Total records: %d", (int)records.size());
+        ImGui::Text("Total records: %d in memory, %d archived on disk (tree height %d)",
+                    (int)records.size(), backend.getArchivedCount(), backend.getTreeHeight());
         ImGui::Spacing();
         
         ImGui::SetWindowFontScale(1.1f);
-        if (ImGui::BeginTable("RecordsTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 600))) {
+        if (ImGui::BeginTable("RecordsTable", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 480))) {
             ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_WidthFixed, 80);
             ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthFixed, 200);
             ImGui::TableSetupColumn("Age", ImGuiTableColumnFlags_WidthFixed, 80);
             ImGui::TableSetupColumn("Priority", ImGuiTableColumnFlags_WidthFixed, 150);
+            ImGui::TableSetupColumn("Admitted", ImGuiTableColumnFlags_WidthFixed, 160);
             ImGui::TableSetupColumn("Symptoms", ImGuiTableColumnFlags_WidthStretch);
             ImGui::TableHeadersRow();
             
@@ -581,7 +1017,7 @@ private:
                 ImGui::Text("%d", pd.patientID);
                 
                 ImGui::TableNextColumn();
-                ImGui::Text("%s", pd.name.c_str());
+                ImGui::Text("%s", backend.text(pd.nameID));
                 
                 ImGui::TableNextColumn();
                 ImGui::Text("%d", pd.age);
@@ -600,7 +1036,106 @@ private:
                 ImGui::PopStyleColor();
                 
                 ImGui::TableNextColumn();
-                ImGui::TextWrapped("%s", pd.symptoms.c_str());
+                if (pd.admissionTime > 0) {
+                    char when[32];
+                    time_t t = (time_t)pd.admissionTime;
+                    strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(&t));
+                    ImGui::Text("%s", when);
+                } else {
+                    ImGui::Text("-");
+                }
+                
+                ImGui::TableNextColumn();
+                ImGui::TextWrapped("%s", backend.text(pd.symptomsID));
+            }
+            
+            ImGui::EndTable();
+        }
+        ImGui::SetWindowFontScale(1.0f);
+    }
+    
+    void renderArchive() {
+        ImGui::SetWindowFontScale(1.5f);
+        ImGui::Text("📦 Archived Patients (Cold Storage)");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::Separator();
+        ImGui::Spacing();
+        
+        ImGui::Text("Archived records: %d", backend.getArchivedCount());
+        ImGui::Spacing();
+        
+        ImGui::PushItemWidth(150);
+        ImGui::InputText("From ID", archiveFromID, 16, ImGuiInputTextFlags_CharsDecimal);
+        ImGui::SameLine();
+        ImGui::InputText("To ID", archiveToID, 16, ImGuiInputTextFlags_CharsDecimal);
+        ImGui::PopItemWidth();
+        
+        ImGui::Checkbox("🔴 Critical", &archivePriority[0]);
+        ImGui::SameLine();
+        ImGui::Checkbox("🟠 Urgent", &archivePriority[1]);
+        ImGui::SameLine();
+        ImGui::Checkbox("🟢 Standard", &archivePriority[2]);
+        ImGui::Spacing();
+        
+        if (ImGui::Button("🔍 Scan Archive", ImVec2(200, 40))) {
+            ArchiveFilter filter;
+            if (strlen(archiveFromID) > 0) filter.minID = atoi(archiveFromID);
+            if (strlen(archiveToID) > 0) filter.maxID = atoi(archiveToID);
+            filter.priorityMask = 0;
+            for (int p = 0; p < 3; p++) {
+                if (archivePriority[p]) filter.priorityMask |= 1u << (p + 1);
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            archiveResults = backend.scanArchive(filter, 1000, archiveGroupsRead, archiveGroupsSkipped);
+            archiveMillis = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            archiveScanned = true;
+        }
+        
+        if (!archiveScanned) return;
+        
+        ImGui::Spacing();
+        ImGui::Text("%d records shown (limit 1000) | %d row groups read, %d skipped | %.1f ms",
+                    (int)archiveResults.size(), archiveGroupsRead, archiveGroupsSkipped, archiveMillis);
+        ImGui::Spacing();
+        
+        ImGui::SetWindowFontScale(1.1f);
+        if (ImGui::BeginTable("ArchiveTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 500))) {
+            ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_WidthFixed, 80);
+            ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthFixed, 200);
+            ImGui::TableSetupColumn("Age", ImGuiTableColumnFlags_WidthFixed, 80);
+            ImGui::TableSetupColumn("Priority", ImGuiTableColumnFlags_WidthFixed, 150);
+            ImGui::TableSetupColumn("Symptoms", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+            
+            for (const auto& r : archiveResults) {
+                ImGui::TableNextRow();
+                
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", r.patientID);
+                
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", r.name.c_str());
+                
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", r.age);
+                
+                ImGui::TableNextColumn();
+                if (r.priorityLevel == 1) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.2f, 0.2f, 1.0f));
+                    ImGui::Text("🔴 Critical");
+                } else if (r.priorityLevel == 2) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.6f, 0.0f, 1.0f));
+                    ImGui::Text("🟠 Urgent");
+                } else {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 0.8f, 0.0f, 1.0f));
+                    ImGui::Text("🟢 Standard");
+                }
+                ImGui::PopStyleColor();
+                
+                ImGui::TableNextColumn();
+                ImGui::TextWrapped("%s", r.symptoms.c_str());
             }
             
             ImGui::EndTable();
@@ -636,14 +1171,29 @@ private:
     void registerPatient() {
         Patient newPatient;
         newPatient.id = backend.getNextID();
-        newPatient.name = std::string(nameInput);
+        newPatient.name = nameInput;
         newPatient.age = atoi(ageInput);
-        newPatient.symptoms = std::string(symptomsInput);
+        newPatient.symptoms = symptomsInput;
         newPatient.priority = selectedPriority;
+        newPatient.department = selectedDepartment;
         
-        backend.addPatient(newPatient);
-        
-        sprintf(statusMessage, "✓ Patient registered successfully! ID: %d", newPatient.id);
+        bool confirmed = false;
+        if (!backend.addPatient(newPatient, confirmed)) {
+            // Keep the form so the entry is not lost
+            if (backend.isStandby()) {
+                strcpy(statusMessage, "✗ Error: Registration is only possible on the primary");
+            } else {
+                sprintf(statusMessage, "✗ Error: ID %d is already taken, patient not registered", newPatient.id);
+            }
+            showStatus = true;
+            statusTimer = 0.0f;
+            return;
+        }
+        if (confirmed) {
+            sprintf(statusMessage, "✓ Patient registered successfully! ID: %d", newPatient.id);
+        } else {
+            sprintf(statusMessage, "✓ Patient registered (ID: %d), standby did not confirm", newPatient.id);
+        }
         showStatus = true;
         statusTimer = 0.0f;
         
@@ -655,29 +1205,190 @@ private:
         ageInput[0] = '\0';
         symptomsInput[0] = '\0';
         selectedPriority = 2;
+        selectedDepartment = GENERAL;
     }
     
     void performSearch() {
         if (strlen(searchIDInput) == 0) {
-            searchResult = nullptr;
+            searchFound = false;
             searchPerformed = false;
             return;
         }
         
         int searchID = atoi(searchIDInput);
-        searchResult = backend.searchPatient(searchID);
+        searchFound = backend.searchPatient(searchID, searchResult);
         searchPerformed = true;
+        editMessage[0] = '\0';
+        confirmDelete = false;
+        if (searchFound) {
+            snprintf(editName, sizeof(editName), "%s", searchResult.name.c_str());
+            snprintf(editAge, sizeof(editAge), "%d", searchResult.age);
+            snprintf(editSymptoms, sizeof(editSymptoms), "%s", searchResult.symptoms.c_str());
+            editPriority = searchResult.priorityLevel;
+        }
+    }
+};
+
+// Read-only status board (--viewer). Maps the backend's queue replica and
+// needs no patients.csv; a refresh is a copy out of shared memory.
+class StatusBoard {
+private:
+    std::string segmentName;
+    ReplicaReader reader;
+    ReplicaSnapshot snap;
+    bool haveSnapshot = false;
+    double lastConnectTry = -10.0;
+    
+    // A writer that stopped publishing (or was replaced) leaves the old
+    // segment behind, so reconnect once the heartbeat is this old
+    static const int STALE_SECONDS = 5;
+    
+public:
+    explicit StatusBoard(const std::string& name) : segmentName(name) {}
+    
+    void render() {
+        double now = ImGui::GetTime();
+        if (!reader.isOpen() && now - lastConnectTry >= 1.0) {
+            lastConnectTry = now;
+            reader.open(segmentName.c_str());
+        }
+        if (reader.read(snap)) haveSnapshot = true;
+        bool stale = haveSnapshot && (long long)time(nullptr) - snap.publishedAt > STALE_SECONDS;
+        if (stale) reader.close();
+        
+        ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+        ImGui::Begin("Status Board", nullptr,
+                     ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoTitleBar);
+        
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.3f, 0.8f, 1.0f, 1.0f));
+        ImGui::SetWindowFontScale(1.8f);
+        ImGui::Text("🏥 Emergency Status Board");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::PopStyleColor();
+        ImGui::Separator();
+        ImGui::Spacing();
+        
+        if (!haveSnapshot) {
+            ImGui::SetWindowFontScale(1.3f);
+            ImGui::Text("Waiting for the emergency system to start...");
+            ImGui::SetWindowFontScale(1.0f);
+            ImGui::End();
+            return;
+        }
+        if (stale) {
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.6f, 0.0f, 1.0f));
+            ImGui::Text("⚠ No update for %lld s, showing last known state",
+                        (long long)time(nullptr) - snap.publishedAt);
+            ImGui::PopStyleColor();
+        }
+        
+        renderNextPatient();
+        ImGui::Spacing();
+        renderCounters();
+        ImGui::Spacing();
+        renderUpcoming();
+        
+        ImGui::End();
+    }
+    
+private:
+    void renderNextPatient() {
+        ImGui::BeginChild("Next", ImVec2(0, 110), true, ImGuiWindowFlags_NoScrollbar);
+        ImGui::SetWindowFontScale(1.3f);
+        ImGui::Text("⏭ Next Patient");
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::Separator();
+        if (snap.entryCount == 0) {
+            ImGui::SetWindowFontScale(1.5f);
+            ImGui::Text("✓ Queue is empty");
+        } else {
+            const ReplicaEntry& e = snap.entries[0];
+            ImGui::SetWindowFontScale(1.5f);
+            ImGui::Text("%s (ID %d) - %s", e.name, e.id, departmentName(e.department));
+        }
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::EndChild();
+    }
+    
+    void renderCounters() {
+        ImGui::BeginChild("Counters", ImVec2(0, 90), true, ImGuiWindowFlags_NoScrollbar);
+        ImGui::SetWindowFontScale(1.2f);
+        ImGui::Text("Waiting: %d", snap.queued);
+        ImGui::SameLine(200);
+        ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "🔴 %d", snap.byPriority[1]);
+        ImGui::SameLine(300);
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "🟠 %d", snap.byPriority[2]);
+        ImGui::SameLine(400);
+        ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "🟢 %d", snap.byPriority[3]);
+        for (int d = 0; d < DEPARTMENTS; d++) {
+            if (d > 0) ImGui::SameLine(0, 40);
+            ImGui::Text("%s: %d", departmentName(d), snap.byDepartment[d]);
+        }
+        ImGui::Text("Treated: %d   Records: %d   Archived: %d",
+                    snap.treated, snap.totalRecords, snap.archived);
+        ImGui::SetWindowFontScale(1.0f);
+        ImGui::EndChild();
+    }
+    
+    void renderUpcoming() {
+        ImGui::SetWindowFontScale(1.2f);
+        if (ImGui::BeginTable("Upcoming", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+            ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_WidthFixed, 80);
+            ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Priority", ImGuiTableColumnFlags_WidthFixed, 150);
+            ImGui::TableSetupColumn("Department", ImGuiTableColumnFlags_WidthFixed, 130);
+            ImGui::TableSetupColumn("Projected", ImGuiTableColumnFlags_WidthFixed, 110);
+            ImGui::TableHeadersRow();
+            
+            for (int i = 0; i < snap.entryCount; i++) {
+                const ReplicaEntry& e = snap.entries[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", e.id);
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", e.name);
+                ImGui::TableNextColumn();
+                if (e.priority == 1) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "🔴 Critical");
+                } else if (e.priority == 2) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "🟠 Urgent");
+                } else {
+                    ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "🟢 Standard");
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", departmentName(e.department));
+                ImGui::TableNextColumn();
+                ImGui::Text("in ~%d min", (int)((i + 1) * snap.serviceSeconds / 60.0 + 0.5));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::SetWindowFontScale(1.0f);
     }
 };
 
-int main() {
+int main(int argc, char** argv) {
+    // --viewer: read-only board fed by a running instance, no data files;
+    // --board=NAME picks the instance when several run on one machine
+    bool viewer = false;
+    ReplicationOptions replication;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--viewer") == 0) viewer = true;
+        else if (strcmp(argv[i], "--standby") == 0) replication.standby = true;
+        else if (strcmp(argv[i], "--ack=sync") == 0) replication.ackMode = ACK_SYNC;
+        else if (strcmp(argv[i], "--ack=async") == 0) replication.ackMode = ACK_ASYNC;
+        else if (strncmp(argv[i], "--board=", 8) == 0) replication.boardName = argv[i] + 8;
+    }
+    
     if (!glfwInit()) return -1;
     
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     
-    GLFWwindow* window = glfwCreateWindow(1200, 800, "Hospital Emergency Management System", NULL, NULL);
+    GLFWwindow* window = viewer
+        ? glfwCreateWindow(900, 600, "Emergency Status Board", NULL, NULL)
+        : glfwCreateWindow(1200, 800, "Hospital Emergency Management System", NULL, NULL);
     if (!window) {
         glfwTerminate();
         return -1;
@@ -701,8 +1412,14 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
     
-    BackendInterface backend;
-    GUIManager gui(backend);
+    // The viewer never loads patient data
+    std::unique_ptr<BackendInterface> backend;
+    std::unique_ptr<GUIManager> gui;
+    StatusBoard board(replication.boardName);
+    if (!viewer) {
+        backend.reset(new BackendInterface(replication));
+        gui.reset(new GUIManager(*backend));
+    }
     
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
@@ -711,7 +1428,17 @@ int main() {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         
-        gui.render();
+        // A standby that can no longer follow (the primary restarted, or
+        // its snapshot broke off) starts over empty
+        if (backend && backend->needsRestart()) {
+            gui.reset();
+            backend.reset();
+            backend.reset(new BackendInterface(replication));
+            gui.reset(new GUIManager(*backend));
+        }
+        
+        if (viewer) board.render();
+        else gui->render();
         
         ImGui::Render();
         int display_w, display_h;
@@ -0,0 +1,24 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdio>
+
+// Minimal assertions for the test programs: a failed CHECK prints the
+// condition and makes the program exit non-zero
+static int checkFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+static int checkResult(const char* name) {
+    printf("%s: %s\n", name, checkFailures == 0 ? "passed" : "FAILED");
+    fflush(stdout);
+    return checkFailures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,90 @@
+// Batch corrections and deletes (the mass-intake panel's retriage and undo):
+// a retriaged patient moves in the queue but keeps its place among equal
+// priorities, deleted patients leave the queue and the record store, and
+// unknown or repeated IDs are ignored.
+#include <set>
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "check.h"
+
+static bool ordered(const vector<Patient>& queue) {
+    for (size_t i = 1; i < queue.size(); i++) {
+        const Patient& a = queue[i - 1];
+        const Patient& b = queue[i];
+        if (a.priority > b.priority || (a.priority == b.priority && a.id > b.id)) return false;
+    }
+    return true;
+}
+
+int main() {
+    const int ROWS = 3000;
+    vector<IntakeRow> rows(ROWS);
+    for (int i = 0; i < ROWS; i++) {
+        rows[i].name = "Patient " + to_string(i);
+        rows[i].age = 30;
+        rows[i].symptoms = "smoke inhalation";
+        rows[i].priority = 3;
+        rows[i].department = i % DEPARTMENTS;
+    }
+    ReplicationOptions options;
+    // Not the default name: that would replace a running instance's board
+    options.boardName = "/hospital_queue_test_" + to_string(getpid());
+    BackendInterface backend(options);
+    backend.finishLoading();
+    bool confirmed;
+    int first = backend.addPatientsBulk(rows, confirmed);
+    CHECK(first > 0);
+
+    // Retriage every tenth patient (odd IDs) to critical, with an unknown ID mixed in
+    vector<PatientRecord> records;
+    PatientRecord r;
+    for (int i = 5; i < ROWS; i += 10) {
+        CHECK(backend.searchPatient(first + i, r));
+        records.push_back(r);
+    }
+    vector<Patient> changes;
+    for (const PatientRecord& rec : records) {
+        Patient p = {rec.patientID, rec.name.c_str(), rec.age, "smoke inhalation, burns", 1, GENERAL};
+        changes.push_back(p);
+    }
+    Patient unknown = {first + ROWS + 5, "Nobody", 40, "none", 1, GENERAL};
+    changes.push_back(unknown);
+    CHECK(backend.updatePatients(changes) == ROWS / 10);
+
+    vector<Patient> queue = backend.getQueuedPatients();
+    CHECK(queue.size() == (size_t)ROWS);
+    CHECK(ordered(queue));
+    CHECK(backend.getPatientsByPriority(1) == ROWS / 10);
+    if (queue.size() == (size_t)ROWS) {
+        CHECK(queue[0].id == first + 5 && queue[ROWS / 10].priority == 3);
+    }
+    CHECK(backend.searchPatient(first + 5, r) && r.priorityLevel == 1 && r.symptoms == "smoke inhalation, burns");
+    CHECK(backend.searchPatient(first + 6, r) && r.priorityLevel == 3 && r.symptoms == "smoke inhalation");
+
+    // Delete the even IDs; one listed twice and one that does not exist
+    vector<int> ids;
+    for (int i = 0; i < ROWS; i += 2) ids.push_back(first + i);
+    ids.push_back(first);
+    ids.push_back(first + ROWS + 5);
+    CHECK(backend.deletePatients(ids) == ROWS / 2);
+
+    queue = backend.getQueuedPatients();
+    CHECK(queue.size() == (size_t)ROWS / 2);
+    CHECK(ordered(queue));
+    bool onlyOdd = true;
+    for (const Patient& p : queue) onlyOdd = onlyOdd && (p.id - first) % 2 == 1;
+    CHECK(onlyOdd);
+    CHECK(!backend.searchPatient(first, r));
+    CHECK(backend.searchPatient(first + 1, r));
+    CHECK(backend.getPatientsByPriority(1) == ROWS / 10);
+
+    // The queue still treats in order after both batches
+    size_t treated = 0;
+    for (; treated < queue.size(); treated++) {
+        if (backend.getNextPatient().id != queue[treated].id) break;
+        backend.treatNextPatient();
+    }
+    CHECK(treated == queue.size());
+    CHECK(backend.getTotalPatients() == 0);
+    return checkResult("test_batch_edit");
+}
@@ -0,0 +1,58 @@
+// Mass-casualty intake larger than 65536 rows: the batch gets one block of
+// IDs, and within a priority level patients are listed and treated in
+// arrival (ID) order, across all departments. The drain also runs with
+// more patients waiting than the hot set holds.
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "check.h"
+
+int main() {
+    const int ROWS = 200000;
+    vector<IntakeRow> rows(ROWS);
+    for (int i = 0; i < ROWS; i++) {
+        rows[i].name = "Casualty " + to_string(i);
+        rows[i].age = 20 + i % 60;
+        rows[i].symptoms = "blast injury";
+        rows[i].priority = 1 + (i % 7 == 0) + (i % 5 == 0);
+        rows[i].department = i % DEPARTMENTS;
+    }
+
+    ReplicationOptions options;
+    // Not the default name: that would replace a running instance's board
+    options.boardName = "/hospital_queue_test_" + to_string(getpid());
+    BackendInterface backend(options);
+    backend.finishLoading();
+    bool confirmed;
+    int first = backend.addPatientsBulk(rows, confirmed);
+    CHECK(first > 0);
+    CHECK(backend.getTotalPatients() == ROWS);
+    PatientRecord r;
+    CHECK(backend.searchPatient(first, r) && r.name == "Casualty 0");
+    CHECK(backend.searchPatient(first + ROWS - 1, r) && r.name == "Casualty " + to_string(ROWS - 1));
+
+    // Listing: priorities ascending, IDs ascending within each
+    vector<Patient> queued = backend.getQueuedPatients();
+    CHECK(queued.size() == (size_t)ROWS);
+    int inversions = 0;
+    for (size_t i = 1; i < queued.size(); i++) {
+        const Patient& a = queued[i - 1];
+        const Patient& b = queued[i];
+        if (a.priority > b.priority || (a.priority == b.priority && a.id > b.id)) inversions++;
+    }
+    CHECK(inversions == 0);
+    // Row 0 has priority 3; row 1 is the first with priority 1
+    CHECK(queued.empty() || queued.front().id == first + 1);
+
+    // Treatment follows the listing
+    int treatedOutOfOrder = 0;
+    for (size_t i = 0; i < queued.size(); i++) {
+        if (backend.getNextPatient().id != queued[i].id) treatedOutOfOrder++;
+        backend.treatNextPatient();
+    }
+    printf("%d listed (%d out of order), %d treated (%d out of order), %d archived\n",
+           (int)queued.size(), inversions, (int)queued.size(), treatedOutOfOrder, backend.getArchivedCount());
+    CHECK(backend.getTotalPatients() == 0);
+    CHECK(backend.getArchivedCount() >= ROWS - (int)HOT_SET_SIZE);
+    CHECK(treatedOutOfOrder == 0);
+    return checkResult("test_bulk_order");
+}
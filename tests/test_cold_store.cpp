@@ -0,0 +1,84 @@
+// Cold store reopen: a row group torn by a crash mid-append is cut off, so a
+// shorter append after it leaves no stale bytes to be read as a header, and a
+// file that is not an archive leaves the store closed rather than appendable.
+#include <fstream>
+#include <unistd.h>
+#include "ColdStore.h"
+#include "check.h"
+
+static vector<PatientRecord> batch(int firstID, int count) {
+    vector<PatientRecord> rows(count);
+    for (int i = 0; i < count; i++) {
+        rows[i].patientID = firstID + i;
+        rows[i].name = "Discharged " + to_string(firstID + i);
+        rows[i].age = 20 + i % 60;
+        rows[i].symptoms = "sprain";
+        rows[i].admissionTime = firstID + i;
+    }
+    return rows;
+}
+
+static long long fileSize(const string& file) {
+    ifstream in(file, ios::binary | ios::ate);
+    return in.is_open() ? (long long)in.tellg() : -1;
+}
+
+static void tornTail() {
+    const string file = "torn_cold.dat";
+    long long complete, torn;
+    {
+        ColdStore store;
+        CHECK(store.open(file));
+        vector<PatientRecord> rows = batch(1, 100);
+        CHECK(store.appendBlock(rows));
+        complete = fileSize(file);
+        rows = batch(1000, 5000);
+        CHECK(store.appendBlock(rows));
+        torn = complete + (fileSize(file) - complete) / 2;
+    }
+    CHECK(truncate(file.c_str(), torn) == 0);
+
+    ColdStore store;
+    CHECK(store.open(file));
+    CHECK(store.size() == 100);
+    CHECK(fileSize(file) == complete);
+
+    // A short append, then a reopen sees exactly the two complete batches
+    vector<PatientRecord> rows = batch(200, 3);
+    CHECK(store.appendBlock(rows));
+    long long end = fileSize(file);
+    ColdStore reopened;
+    CHECK(reopened.open(file));
+    CHECK(reopened.size() == 103);
+    CHECK(fileSize(file) == end);
+    PatientRecord r;
+    CHECK(reopened.find(202, r) && r.name == "Discharged 202");
+    CHECK(reopened.find(50, r) && r.name == "Discharged 50");
+    CHECK(!reopened.find(1000, r));
+}
+
+static void badMagic() {
+    const string good = "good_cold.dat", bad = "bad_cold.dat";
+    {
+        ofstream out(bad, ios::binary);
+        out << "not an archive at all";
+    }
+    long long before = fileSize(bad);
+
+    ColdStore store;
+    CHECK(store.open(good));
+    CHECK(store.isOpen());
+    // Reopening on a bad file closes the store; appends are refused
+    CHECK(!store.open(bad));
+    CHECK(!store.isOpen());
+    vector<PatientRecord> rows = batch(1, 10);
+    CHECK(!store.appendBlock(rows));
+    CHECK(fileSize(bad) == before);
+    CHECK(store.size() == 0);
+}
+
+int main() {
+    tornTail();
+    badMagic();
+    return checkResult("test_cold_store");
+}
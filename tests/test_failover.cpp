@@ -0,0 +1,167 @@
+// Failover drill: a forked primary registers patients (and treats every
+// fourth) under load while this process runs a standby at 16 ms frames.
+// The primary is SIGKILLed after 2 s; the test measures the time until the
+// standby has promoted itself and counts the operations the primary had
+// confirmed that the standby does not have. With --ack=sync none may be
+// lost. Runs with `make test`, or alone with `make failover`.
+#include <chrono>
+#include <set>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "check.h"
+
+using namespace std::chrono;
+
+// What the primary reports for each confirmed operation
+struct Confirmed {
+    int op; // LOG_REGISTER or LOG_TREAT
+    int id;
+};
+
+static void frame(BackendInterface& backend) {
+    backend.poll();
+    std::this_thread::sleep_for(milliseconds(16));
+}
+
+// Read every frame: a full pipe would stall the primary. Each record is
+// one write smaller than PIPE_BUF, so reads never split one
+static void drain(int fd, vector<Confirmed>& out) {
+    Confirmed batch[1024];
+    ssize_t n;
+    while ((n = read(fd, batch, sizeof(batch))) > 0)
+        out.insert(out.end(), batch, batch + n / sizeof(Confirmed));
+}
+
+// Each process publishes its own status board, never the default one
+static string boardName(pid_t pid) {
+    return "/hospital_queue_test_" + to_string(pid);
+}
+
+// Child: waits until the standby holds its snapshot, then works until killed
+static void runPrimary(AckMode mode, int opsPerSecond, int report, int ready) {
+    ReplicationOptions options;
+    options.ackMode = mode;
+    options.boardName = boardName(getpid());
+    BackendInterface backend(options);
+    char go;
+    while (read(ready, &go, 1) != 1) frame(backend);
+
+    steady_clock::time_point start = steady_clock::now(), lastPoll = start;
+    for (int i = 0; ; i++) {
+        Patient p = {backend.getNextID(), "Drill Patient", 40, "chest pain", 1 + i % 3, i % DEPARTMENTS};
+        bool confirmed;
+        if (backend.addPatient(p, confirmed) && confirmed) {
+            Confirmed c = {LOG_REGISTER, p.id};
+            if (write(report, &c, sizeof(c)) != sizeof(c)) _exit(1);
+        }
+        if (i % 4 == 3) {
+            Patient next = backend.getNextPatient();
+            backend.treatNextPatient();
+            // treatNextPatient has no result; in sync mode it is confirmed
+            // once the standby caught up
+            if (next.id >= 0 && (mode == ACK_ASYNC || backend.standbyLag() == 0)) {
+                Confirmed c = {LOG_TREAT, next.id};
+                if (write(report, &c, sizeof(c)) != sizeof(c)) _exit(1);
+            }
+        }
+        if (steady_clock::now() - lastPoll > milliseconds(16)) {
+            backend.poll();
+            lastPoll = steady_clock::now();
+        }
+        if (opsPerSecond > 0)
+            std::this_thread::sleep_until(start + microseconds((long long)(i + 1) * 1000000 / opsPerSecond));
+    }
+}
+
+static void drill(const char* name, AckMode mode, int opsPerSecond) {
+    // Own directory: the socket and data files are relative paths
+    mkdir(name, 0755);
+    CHECK(chdir(name) == 0);
+    int report[2], ready[2];
+    CHECK(pipe(report) == 0 && pipe(ready) == 0);
+
+    pid_t child = fork();
+    if (child == 0) {
+        close(report[0]);
+        close(ready[1]);
+        fcntl(ready[0], F_SETFL, O_NONBLOCK);
+        runPrimary(mode, opsPerSecond, report[1], ready[0]);
+        _exit(0);
+    }
+    close(report[1]);
+    close(ready[0]);
+    fcntl(report[0], F_SETFL, O_NONBLOCK);
+    vector<Confirmed> confirmed;
+
+    bool promoted = false;
+    double failoverMillis = -1;
+    {
+        ReplicationOptions options;
+        options.standby = true;
+        options.ackMode = mode;
+        options.boardName = boardName(getpid());
+        BackendInterface standby(options);
+
+        steady_clock::time_point deadline = steady_clock::now() + seconds(10);
+        while (!standby.getReceiver().isSynced() && steady_clock::now() < deadline) frame(standby);
+        CHECK(standby.getReceiver().isSynced());
+        CHECK(write(ready[1], "g", 1) == 1);
+
+        steady_clock::time_point until = steady_clock::now() + seconds(2);
+        while (steady_clock::now() < until) {
+            frame(standby);
+            drain(report[0], confirmed);
+        }
+
+        kill(child, SIGKILL);
+        steady_clock::time_point killed = steady_clock::now();
+        deadline = killed + seconds(10);
+        while (standby.isStandby() && steady_clock::now() < deadline) frame(standby);
+        promoted = !standby.isStandby();
+        failoverMillis = duration<double, std::milli>(steady_clock::now() - killed).count();
+        waitpid(child, nullptr, 0);
+        shm_unlink(boardName(child).c_str()); // the killed primary's board
+        drain(report[0], confirmed);
+
+        // Everything the primary confirmed must be on the standby
+        set<int> waiting;
+        for (const Patient& p : standby.getQueuedPatients()) waiting.insert(p.id);
+        int registered = 0, treated = 0, lostRegistrations = 0, lostTreatments = 0;
+        PatientRecord record;
+        for (const Confirmed& c : confirmed) {
+            if (c.op == LOG_REGISTER) {
+                registered++;
+                if (!standby.searchPatient(c.id, record)) lostRegistrations++;
+            } else {
+                treated++;
+                if (waiting.count(c.id)) lostTreatments++;
+            }
+        }
+        printf("%-22s %6d registered, %5d treated: lost %d + %d, failover %.0f ms\n",
+               name, registered, treated, lostRegistrations, lostTreatments, failoverMillis);
+        CHECK(registered > 0);
+        if (mode == ACK_SYNC) {
+            CHECK(lostRegistrations == 0 && lostTreatments == 0);
+            // Acks come from the standby's reader thread, not once per
+            // standby frame (that would allow about 125 in 2 s)
+            CHECK(registered > 1000);
+        }
+    }
+    CHECK(promoted);
+    CHECK(failoverMillis < 2000);
+    close(report[0]);
+    close(ready[1]);
+    CHECK(chdir("..") == 0);
+}
+
+int main() {
+    drill("async-2500-per-s", ACK_ASYNC, 2500);
+    drill("async-unthrottled", ACK_ASYNC, 0);
+    drill("sync", ACK_SYNC, 0);
+    return checkResult("test_failover");
+}
@@ -0,0 +1,92 @@
+// patients.csv round trip: text with commas, quotes and newlines comes back
+// as written, malformed rows are counted, and a file with skipped rows is
+// never saved over.
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "check.h"
+
+static vector<PatientRecord> loadAll(const string& filename, PatientLoader& loader) {
+    vector<PatientRecord> all, batch;
+    CHECK(loader.start(filename));
+    while (!loader.done()) {
+        while (loader.take(batch, 1024) > 0) all.insert(all.end(), batch.begin(), batch.end());
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return all;
+}
+
+static string readFile(const string& filename) {
+    ifstream in(filename, ios::binary);
+    stringstream s;
+    s << in.rdbuf();
+    return s.str();
+}
+
+int main() {
+    const char* names[] = { "Plain Name", "Doe, Jane", "Dwayne \"The Rock\"", "" };
+    const char* symptoms[] = {
+        "fever",
+        "chest pain, shortness of breath",
+        "fell off a ladder\n2 hours ago\r\n\"very\" dizzy,\nnauseous",
+        "\"",
+    };
+    const int ROWS = 4;
+
+    {
+        PatientRecordsBST records;
+        for (int i = 0; i < ROWS; i++)
+            records.insertPatient(PatientData(i + 1, records.intern(names[i]), 30 + i,
+                                              records.intern(symptoms[i]), 1 + i % 3, 1000 + i));
+        CHECK(records.saveToFile("round_trip.csv"));
+    }
+    PatientLoader loader;
+    vector<PatientRecord> loaded = loadAll("round_trip.csv", loader);
+    CHECK(loader.skippedRows() == 0);
+    CHECK(loaded.size() == (size_t)ROWS);
+    for (size_t i = 0; i < loaded.size() && i < (size_t)ROWS; i++) {
+        CHECK(loaded[i].patientID == (int)i + 1);
+        CHECK(loaded[i].name == names[i]);
+        CHECK(loaded[i].age == 30 + (int)i);
+        CHECK(loaded[i].symptoms == symptoms[i]);
+        CHECK(loaded[i].priorityLevel == 1 + (int)i % 3);
+        CHECK(loaded[i].admissionTime == 1000 + (long long)i);
+    }
+    // The line "2 hours ago" inside a quoted field is not an ID
+    CHECK(PatientLoader::scanMaxID("round_trip.csv") == ROWS);
+
+    // Two malformed rows: a bad age and an unterminated quote at the end
+    string original =
+        "PatientID,Name,Age,Symptoms,Priority,AdmissionTime\n"
+        "7,Good Row,40,\"cough, mild\",3,500\n"
+        "8,Bad Age,forty,cough,3,500\n"
+        "9,Also Good,41,headache,2,501\n"
+        "\n"
+        "10,Broken,42,\"never closed,1,502\n";
+    {
+        ofstream out("patients.csv", ios::binary);
+        out << original;
+    }
+    {
+        ReplicationOptions options;
+        // Not the default name: that would replace a running instance's board
+        options.boardName = "/hospital_queue_test_" + to_string(getpid());
+        BackendInterface backend(options);
+        backend.finishLoading();
+        CHECK(backend.getSkippedRows() == 2);
+        CHECK(string(backend.getSavePath()) != "patients.csv");
+        CHECK(backend.saveToFile());
+        PatientRecord r;
+        CHECK(backend.searchPatient(7, r) && r.symptoms == "cough, mild");
+        CHECK(backend.searchPatient(9, r));
+        CHECK(!backend.searchPatient(8, r));
+    }
+    // The exit save went beside it too
+    CHECK(readFile("patients.csv") == original);
+    PatientLoader recovered;
+    CHECK(loadAll("patients_recovered.csv", recovered).size() == 2);
+    CHECK(recovered.skippedRows() == 0);
+    return checkResult("test_patients_csv");
+}
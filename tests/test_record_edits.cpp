@@ -0,0 +1,241 @@
+// Record store edits against a reference map: 400 randomized rounds of
+// single inserts, fresh and overlapping blocks, deletes and updates (single
+// and batched) keep the AVL invariant, the ID index and the admission-time
+// ranges exact. Then: a freed handle reused by a new patient is not evicted
+// through the old patient's discharge, archived records are read-only, and
+// the backend refuses a taken ID and keeps the queue in order through
+// single updates and deletes.
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "check.h"
+
+static mt19937 rng(42);
+
+static int randomInt(int lo, int hi) {
+    return lo + (int)(rng() % (unsigned)(hi - lo + 1));
+}
+
+// IDs admitted in [from, to] according to the store, checking oldest first
+static vector<int> storeBetween(PatientRecordsBST& records, long long from, long long to) {
+    vector<int> ids;
+    long long last = from;
+    for (int handle : records.admittedBetween(from, to)) {
+        PatientData* pd = records.getRecord(handle);
+        if (!pd || pd->admissionTime < last) return vector<int>(1, -1);
+        last = pd->admissionTime;
+        ids.push_back(pd->patientID);
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static vector<int> modelBetween(const map<int, long long>& model, long long from, long long to) {
+    vector<int> ids;
+    for (const auto& m : model)
+        if (m.second >= from && m.second <= to) ids.push_back(m.first);
+    return ids;
+}
+
+static void randomizedRounds() {
+    const long long TIMES = 5000; // few enough admission times to collide
+    PatientRecordsBST records;
+    unsigned int text = records.intern("x");
+    map<int, long long> model; // ID -> admission time
+    int nextID = 1;
+    bool consistent = true, sizes = true, heights = true, ranges = true, results = true;
+
+    for (int round = 0; round < 400; round++) {
+        for (int op = 0; op < 20; op++) {
+            switch (randomInt(0, 6)) {
+            case 0: { // single insert, sometimes a duplicate
+                int id = randomInt(1, nextID + 20);
+                long long t = randomInt(0, TIMES);
+                bool fresh = !model.count(id);
+                int handle = records.insertPatient(PatientData(id, text, 30, text, 3, t));
+                results = results && (handle >= 0) == fresh;
+                if (fresh) model[id] = t;
+                nextID = max(nextID, id + 1);
+                break;
+            }
+            case 1: { // fresh block above every ID: joined as a subtree
+                int k = randomInt(1, 40);
+                vector<PatientData> block;
+                for (int i = 0; i < k; i++) {
+                    block.push_back(PatientData(nextID + i, text, 30, text, 3, randomInt(0, TIMES)));
+                    model[nextID + i] = block.back().admissionTime;
+                }
+                nextID += k;
+                for (int handle : records.insertBlock(block)) results = results && handle >= 0;
+                break;
+            }
+            case 2: { // block overlapping existing IDs: inserted one by one
+                vector<PatientData> block;
+                for (int id = randomInt(1, nextID); id < nextID && block.size() < 50; id += randomInt(1, 4))
+                    block.push_back(PatientData(id, text, 30, text, 3, randomInt(0, TIMES)));
+                vector<int> handles = records.insertBlock(block);
+                for (size_t i = 0; i < block.size(); i++) {
+                    bool fresh = !model.count(block[i].patientID);
+                    results = results && (handles[i] >= 0) == fresh;
+                    if (fresh) model[block[i].patientID] = block[i].admissionTime;
+                }
+                break;
+            }
+            case 3: // single delete, sometimes of a missing ID
+            case 4: {
+                int id = randomInt(1, nextID);
+                bool present = model.count(id) > 0;
+                results = results && (records.deletePatient(id) >= 0) == present;
+                model.erase(id);
+                break;
+            }
+            case 5: { // single update to a new admission time
+                int id = randomInt(1, nextID);
+                long long t = randomInt(0, TIMES);
+                bool present = model.count(id) > 0;
+                results = results && (records.updatePatient(id, PatientData(id, text, 31, text, 1, t)) >= 0) == present;
+                if (present) model[id] = t;
+                break;
+            }
+            default: { // batches: update some, then delete some
+                vector<PatientData> changes;
+                vector<int> doomed;
+                for (int i = 0; i < 30; i++) {
+                    int id = randomInt(1, nextID);
+                    if (!model.count(id)) continue;
+                    bool listed = false;
+                    for (const PatientData& c : changes) listed = listed || c.patientID == id;
+                    if (listed) continue;
+                    changes.push_back(PatientData(id, text, 32, text, 2, randomInt(0, TIMES)));
+                    model[id] = changes.back().admissionTime;
+                }
+                records.updatePatients(changes);
+                for (int i = 0; i < 20; i++) {
+                    int id = randomInt(1, nextID);
+                    if (!model.count(id) || find(doomed.begin(), doomed.end(), id) != doomed.end()) continue;
+                    doomed.push_back(id);
+                    model.erase(id);
+                }
+                records.deletePatients(doomed);
+                break;
+            }
+            }
+        }
+
+        consistent = consistent && records.isConsistent();
+        sizes = sizes && records.liveCount() == (int)model.size();
+        // AVL bound: height < 1.4405 log2(n + 2)
+        heights = heights && records.treeHeight() <= 1.4405 * log2(model.size() + 2.0);
+        for (int q = 0; q < 3; q++) {
+            long long from = randomInt(0, TIMES), to = from + randomInt(0, TIMES / 4);
+            ranges = ranges && storeBetween(records, from, to) == modelBetween(model, from, to);
+        }
+    }
+    printf("%d records after 400 rounds, tree height %d\n", (int)model.size(), records.treeHeight());
+    CHECK(consistent);
+    CHECK(sizes);
+    CHECK(heights);
+    CHECK(ranges);
+    CHECK(results);
+    CHECK(storeBetween(records, 0, TIMES) == modelBetween(model, 0, TIMES));
+}
+
+// A discharged patient deleted before eviction leaves its (handle, ID) in
+// the discharge list; the patient who reuses the handle stays hot
+static void reusedHandle() {
+    PatientRecordsBST records;
+    CHECK(records.openColdStore("reuse_cold.dat"));
+    records.setHotLimit(10);
+    unsigned int text = records.intern("x");
+    for (int id = 1; id <= 20; id++) records.insertPatient(PatientData(id, text, 30, text, 3, id));
+
+    int freed = records.findHandle(5);
+    records.markDischarged(freed);
+    CHECK(records.deletePatient(5) == freed);
+    CHECK(records.insertPatient(PatientData(100, text, 30, text, 3, 100)) == freed);
+    // Discharge enough others that eviction has a full block to take
+    for (int id = 6; id <= 20; id++) records.markDischarged(records.findHandle(id));
+
+    vector<int> evicted = records.evictColdRecords();
+    CHECK(!evicted.empty());
+    CHECK(find(evicted.begin(), evicted.end(), freed) == evicted.end());
+    CHECK(records.searchPatient(100) != nullptr);
+    CHECK(records.isConsistent());
+}
+
+// Archived rows can be read but not corrected, deleted or inserted again
+static void coldIsReadOnly() {
+    PatientRecordsBST records;
+    CHECK(records.openColdStore("readonly_cold.dat"));
+    records.setHotLimit(10);
+    unsigned int text = records.intern("x");
+    for (int id = 1; id <= 20; id++) {
+        records.insertPatient(PatientData(id, text, 30, text, 3, id));
+        records.markDischarged(records.findHandle(id));
+    }
+    records.evictColdRecords();
+    CHECK(records.coldCount() > 0);
+    CHECK(records.searchPatient(1) == nullptr);
+
+    PatientRecord r;
+    CHECK(records.findPatient(1, r) && r.patientID == 1);
+    CHECK(records.updatePatient(1, PatientData(1, text, 99, text, 1, 1)) == -1);
+    CHECK(records.deletePatient(1) == -1);
+    CHECK(records.insertPatient(PatientData(1, text, 30, text, 3, 1)) == -1);
+    CHECK(records.findPatient(1, r) && r.age == 30);
+    CHECK(records.isConsistent());
+}
+
+// Single corrections and deletes through the backend, queue included
+static void backendSingleEdits() {
+    ReplicationOptions options;
+    // Not the default name: that would replace a running instance's board
+    options.boardName = "/hospital_queue_test_" + to_string(getpid());
+    BackendInterface backend(options);
+    backend.finishLoading();
+    vector<int> ids;
+    bool confirmed;
+    for (int i = 0; i < 300; i++) {
+        Patient p = {backend.getNextID(), "Walk In", 30, "cough", 3, i % DEPARTMENTS};
+        CHECK(backend.addPatient(p, confirmed) && confirmed);
+        ids.push_back(p.id);
+    }
+    // A taken ID is refused, not reported as registered
+    Patient taken = {ids[10], "Someone Else", 50, "fracture", 1, TRAUMA};
+    CHECK(!backend.addPatient(taken, confirmed) && !confirmed);
+    CHECK(backend.getTotalPatients() == 300);
+
+    Patient retriaged = {ids[200], "Walk In", 30, "cough, now wheezing", 1, GENERAL};
+    CHECK(backend.updatePatient(retriaged));
+    CHECK(backend.getNextPatient().id == ids[200]);
+    PatientRecord r;
+    CHECK(backend.searchPatient(ids[200], r) && r.symptoms == "cough, now wheezing" && r.priorityLevel == 1);
+
+    CHECK(backend.deletePatient(ids[200]));
+    CHECK(!backend.deletePatient(ids[200]));
+    CHECK(!backend.searchPatient(ids[200], r));
+    CHECK(backend.deletePatient(ids[0]));
+    Patient missing = {ids.back() + 1000, "Nobody", 30, "none", 1, GENERAL};
+    CHECK(!backend.updatePatient(missing));
+
+    vector<Patient> queue = backend.getQueuedPatients();
+    CHECK(queue.size() == 298);
+    size_t treated = 0;
+    for (; treated < queue.size(); treated++) {
+        int expected = ids[treated + 1 + (treated + 1 >= 200 ? 1 : 0)];
+        if (queue[treated].id != expected || backend.getNextPatient().id != expected) break;
+        backend.treatNextPatient();
+    }
+    CHECK(treated == queue.size());
+}
+
+int main() {
+    randomizedRounds();
+    reusedHandle();
+    coldIsReadOnly();
+    backendSingleEdits();
+    return checkResult("test_record_edits");
+}
@@ -0,0 +1,83 @@
+// Counts heap allocations made by BackendInterface::addPatient and checks
+// that the text fields cost at most one string allocation each (the copy
+// kept in the replication log); the record itself only stores pool IDs.
+#include <new>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "BackendInterface.h"
+#include "check.h"
+
+// Only allocations on the registering thread are counted
+static __thread bool counting = false;
+static __thread size_t allocations = 0;
+static __thread size_t nameSized = 0;
+static __thread size_t symptomsSized = 0;
+static size_t nameLength = 0;
+static size_t symptomsLength = 0;
+
+// A std::string of n characters asks for n + 1 bytes (plus a header with
+// the old copy-on-write ABI)
+static bool stringSized(size_t bytes, size_t length) {
+    return bytes >= length + 1 && bytes <= length + 1 + 3 * sizeof(size_t);
+}
+
+void* operator new(size_t size) {
+    if (counting) {
+        allocations++;
+        if (stringSized(size, nameLength)) nameSized++;
+        if (stringSized(size, symptomsLength)) symptomsSized++;
+    }
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+int main() {
+    const int COUNT = 100000;
+    ReplicationOptions options;
+    // Not the default name: that would replace a running instance's board
+    options.boardName = "/hospital_queue_test_" + to_string(getpid());
+    BackendInterface backend(options);
+
+    // Long enough to defeat the small-string buffer, of different lengths
+    // so the two fields can be told apart, and with size windows clear of
+    // the power-of-two sizes that container growth asks for
+    string name(70, 'n');
+    string symptoms(150, 's');
+    nameLength = name.size();
+    symptomsLength = symptoms.size();
+
+    // The first registrations grow every container from empty through
+    // small sizes that could pass for a string; count after them
+    const int WARMUP = 1000;
+    size_t worstName = 0, worstSymptoms = 0;
+    for (int i = -WARMUP; i < COUNT; i++) {
+        counting = i >= 0;
+        // Unique text, like real registrations
+        snprintf(&name[0], 12, "%011d", i);
+        snprintf(&symptoms[0], 12, "%011d", i);
+        name[11] = symptoms[11] = '-';
+
+        size_t names = nameSized, symptomTexts = symptomsSized;
+        Patient p = {backend.getNextID(), name.c_str(), 40, symptoms.c_str(), 1 + i % 3, i % DEPARTMENTS};
+        bool confirmed;
+        backend.addPatient(p, confirmed);
+        worstName = max(worstName, nameSized - names);
+        worstSymptoms = max(worstSymptoms, symptomsSized - symptomTexts);
+    }
+    counting = false;
+
+    printf("%d registrations: %.2f allocations each, %zu name-sized (worst %zu), %zu symptoms-sized (worst %zu)\n",
+           COUNT, (double)allocations / COUNT, nameSized, worstName, symptomsSized, worstSymptoms);
+    CHECK(backend.getTotalPatients() == WARMUP + COUNT);
+    CHECK(nameSized <= (size_t)COUNT);
+    CHECK(symptomsSized <= (size_t)COUNT);
+    CHECK(worstName <= 1);
+    CHECK(worstSymptoms <= 1);
+    return checkResult("test_registration_allocs");
+}
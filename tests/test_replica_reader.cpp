@@ -0,0 +1,91 @@
+// ReplicaReader against a writer publishing back to back: every snapshot a
+// read returns must be one the writer published whole, and a read that
+// gives up must leave the caller's last snapshot untouched.
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "QueueReplica.h"
+#include "check.h"
+
+// Every field the writer fills carries the same generation number
+static void fill(ReplicaSnapshot& s, int generation) {
+    memset(&s, 0, sizeof(s));
+    s.publishedAt = generation;
+    s.queued = generation;
+    s.treated = generation;
+    s.entryCount = REPLICA_MAX_ENTRIES;
+    for (int i = 0; i < REPLICA_MAX_ENTRIES; i++) {
+        s.entries[i].id = generation;
+        memset(s.entries[i].name, 'a' + generation % 26, sizeof(s.entries[i].name) - 1);
+    }
+}
+
+static bool whole(const ReplicaSnapshot& s) {
+    long long g = s.publishedAt;
+    if (s.queued != g || s.treated != g || s.entryCount != REPLICA_MAX_ENTRIES) return false;
+    for (int i = 0; i < REPLICA_MAX_ENTRIES; i++)
+        if (s.entries[i].id != g || s.entries[i].name[0] != 'a' + g % 26) return false;
+    return true;
+}
+
+int main() {
+    string name = "/hospital_queue_test_" + to_string(getpid());
+    ReplicaPublisher publisher;
+    ReplicaReader reader;
+    CHECK(publisher.open(name.c_str()));
+    CHECK(reader.open(name.c_str()));
+
+    ReplicaSnapshot snap;
+    fill(snap, 0);
+    CHECK(!reader.read(snap)); // nothing published yet
+
+    atomic<bool> stop(false);
+    thread writer([&]() {
+        ReplicaSnapshot s;
+        for (int generation = 1; !stop.load(); generation++) {
+            fill(s, generation);
+            publisher.publish(s);
+        }
+    });
+
+    long long reads = 0, torn = 0, lastGood = -1;
+    chrono::steady_clock::time_point end = chrono::steady_clock::now() + chrono::milliseconds(500);
+    while (chrono::steady_clock::now() < end) {
+        if (reader.read(snap)) {
+            reads++;
+            if (!whole(snap)) torn++;
+            lastGood = snap.publishedAt;
+        } else if (lastGood >= 0) {
+            CHECK(snap.publishedAt == lastGood && whole(snap));
+        }
+    }
+    stop.store(true);
+    writer.join();
+    printf("%lld reads, %lld torn\n", reads, torn);
+    CHECK(reads > 0);
+    CHECK(torn == 0);
+
+    // A writer that dies mid-write leaves the sequence odd (it follows
+    // magic and version in the segment header); reads then fail and keep
+    // the last good snapshot
+    CHECK(reader.read(snap));
+    ReplicaSnapshot kept = snap;
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    CHECK(fd >= 0);
+    void* mem = mmap(nullptr, sizeof(ReplicaSnapshot) + 64, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK(mem != MAP_FAILED);
+    close(fd);
+    if (fd >= 0 && mem != MAP_FAILED) {
+        atomic<unsigned int>* seq = reinterpret_cast<atomic<unsigned int>*>(static_cast<char*>(mem) + 2 * sizeof(unsigned int));
+        seq->fetch_add(1);
+        CHECK(!reader.read(snap));
+        CHECK(memcmp(&snap, &kept, sizeof(snap)) == 0);
+        munmap(mem, sizeof(ReplicaSnapshot) + 64);
+    }
+    return checkResult("test_replica_reader");
+}
@@ -0,0 +1,163 @@
+// LogShipper retention: without a standby the log stays capped, a standby
+// that acknowledges everything lets it drain to nothing, and a standby
+// that comes back after its entries were dropped is told to resync. Acks
+// sent while the primary is not reading stay whole and the newest arrives.
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "ReplicationLog.h"
+#include "check.h"
+
+static LogEntry treat(int id) {
+    LogEntry e;
+    e.op = LOG_TREAT;
+    e.patientID = id;
+    return e;
+}
+
+template <typename Cond>
+static bool waitFor(Cond cond, int seconds) {
+    chrono::steady_clock::time_point end = chrono::steady_clock::now() + chrono::seconds(seconds);
+    while (!cond()) {
+        if (chrono::steady_clock::now() > end) return false;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t r = recv(fd, p, n, 0);
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+int main() {
+    const unsigned long long TOTAL = LOG_RETAINED_ENTRIES + 5000;
+
+    // Nobody listening: the log keeps only a bounded tail
+    {
+        LogShipper shipper;
+        shipper.start("test_nobody.sock", ACK_ASYNC);
+        vector<LogEntry> batch;
+        for (unsigned long long i = 0; i < TOTAL; i++) {
+            batch.push_back(treat((int)i));
+            if (batch.size() == 1000) shipper.appendBatch(batch);
+        }
+        shipper.appendBatch(batch);
+        CHECK(shipper.lastLSN() == TOTAL);
+        CHECK(shipper.retainedEntries() == LOG_RETAINED_ENTRIES);
+        shipper.stop(false);
+    }
+
+    // A standby that acknowledges: the snapshot comes first, then every
+    // entry once and in order, and the primary keeps nothing it applied
+    {
+        LogReceiver receiver;
+        CHECK(receiver.start("test_standby.sock"));
+        LogShipper shipper;
+        for (int i = 0; i < 100; i++) shipper.append(treat(i));
+        shipper.start("test_standby.sock", ACK_ASYNC);
+        CHECK(waitFor([&] { return shipper.snapshotRequested(); }, 5));
+        vector<LogEntry> state(1);
+        state[0].op = LOG_STATE;
+        shipper.provideSnapshot(state);
+        for (int i = 100; i < 20000; i++) shipper.append(treat(i));
+
+        vector<LogEntry> got, batch;
+        waitFor([&] {
+            receiver.take(batch);
+            got.insert(got.end(), batch.begin(), batch.end());
+            if (!batch.empty()) receiver.acknowledge(batch.back().lsn);
+            return got.size() >= 1 + 19900 && shipper.retainedEntries() == 0;
+        }, 10);
+        CHECK(receiver.isSynced());
+        CHECK(got.size() == 1 + 19900);
+        if (!got.empty()) CHECK(got[0].op == LOG_STATE && got[0].lsn == 100);
+        bool inOrder = true;
+        for (size_t i = 1; i < got.size(); i++) inOrder = inOrder && got[i].lsn == 100 + i;
+        CHECK(inOrder);
+        CHECK(shipper.retainedEntries() == 0);
+        CHECK(!receiver.needsRestart());
+        shipper.stop(true);
+        CHECK(waitFor([&] { return receiver.primaryShutDown(); }, 5));
+        CHECK(!receiver.lost());
+    }
+
+    // A standby that had LSN 1 returns after the cap dropped it: it gets a
+    // resync frame, not the log
+    {
+        unlink("test_behind.sock");
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, "test_behind.sock");
+        CHECK(bind(listener, (sockaddr*)&addr, sizeof(addr)) == 0 && listen(listener, 1) == 0);
+
+        LogShipper shipper;
+        vector<LogEntry> batch;
+        for (unsigned long long i = 0; i < TOTAL; i++) batch.push_back(treat((int)i));
+        shipper.appendBatch(batch);
+        shipper.start("test_behind.sock", ACK_ASYNC);
+
+        int fd = accept(listener, nullptr, nullptr);
+        unsigned long long session = 0, have = 1, start = 0;
+        unsigned int header[2] = { 0, 0 };
+        CHECK(readAll(fd, &session, sizeof(session)));
+        CHECK(send(fd, &have, sizeof(have), 0) == (ssize_t)sizeof(have));
+        CHECK(readAll(fd, &start, sizeof(start)) && start == have);
+        CHECK(readAll(fd, header, sizeof(header)));
+        CHECK(header[1] == RESYNC_FRAME);
+        close(fd);
+        close(listener);
+        shipper.stop(false);
+        unlink("test_behind.sock");
+    }
+
+    // A primary that stops reading acks: the standby's socket fills, yet
+    // no ack call blocks, and once the primary reads again it gets whole,
+    // increasing acks ending with the newest
+    {
+        LogReceiver receiver;
+        CHECK(receiver.start("test_acks.sock"));
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, "test_acks.sock");
+        CHECK(connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+        unsigned long long session = 7, have = 1, start = 0;
+        CHECK(send(fd, &session, sizeof(session), 0) == (ssize_t)sizeof(session));
+        CHECK(readAll(fd, &have, sizeof(have)) && have == 0);
+        CHECK(send(fd, &start, sizeof(start), 0) == (ssize_t)sizeof(start));
+        CHECK(waitFor([&] { return receiver.isConnected(); }, 5));
+
+        const unsigned long long ACKS = 20000;
+        chrono::steady_clock::time_point began = chrono::steady_clock::now();
+        for (unsigned long long lsn = 1; lsn <= ACKS; lsn++) receiver.acknowledge(lsn);
+        CHECK(chrono::steady_clock::now() - began < chrono::seconds(1));
+
+        unsigned long long last = 0, lsn;
+        bool increasing = true;
+        while (last < ACKS) {
+            pollfd p = { fd, POLLIN, 0 };
+            if (poll(&p, 1, 2000) <= 0 || !readAll(fd, &lsn, sizeof(lsn))) break;
+            increasing = increasing && lsn > last && lsn <= ACKS;
+            last = lsn;
+        }
+        CHECK(increasing);
+        CHECK(last == ACKS);
+        close(fd);
+        receiver.stop();
+    }
+    return checkResult("test_replication_log");
+}